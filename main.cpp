@@ -2,118 +2,196 @@
 #include <cctype>     // Garanta que está incluído para o limpador
 #include <iostream>
 #include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <memory>
+#include <fstream>
+#include <sstream>
+#include <deque>
+#include <map>
+#include <iterator>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <random>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <csignal>
+#define TEM_MMAP 1
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TEM_X86 1
+#endif
 
 #include <vector>
 using namespace std;
 
 // Classe Lista
-// Class Node
-template<typename T> class Node {
-private:
-    T item;
-
-public:
-    Node<T>* left;
-    Node<T>* right;
-    Node<T> *next;
-    Node<T> *prev;
-    Node<T> *parent;
-    T getItem();
-    Node();
-    Node(T item);
-    int height;
-    int balanceFactor;
-
-};
-
-template<typename T>
-Node<T>::Node() {
-    next = nullptr;
-    prev = nullptr;
-    left = nullptr;
-    right = nullptr;
-    parent = nullptr;
-    height = 0;
-    balanceFactor = 0;
-}
-
-template<typename T>
-Node<T>::Node(T item) {
-    this->item = item;
-    next = nullptr;
-    prev = nullptr;
-     left = nullptr;
-    right = nullptr;
-    parent = nullptr;
-    height = 0;
-    balanceFactor = 0;
-}
-
-template<typename T> T Node<T>::getItem() { return item; }
-
+// Deque em blocos: os itens ficam em blocos de ~4 KiB e um mapa de ponteiros pros blocos
+// funciona como anel, entao inserir/remover nas duas pontas e O(1) e nao tem ponteiro
+// nenhum por item (antes cada palavra ia num Node com 5 ponteiros + 2 ints e o
+// removeBack andava a lista inteira pra achar o anterior). Bloco que esvazia e devolvido
+// na hora, entao esvaziar pela frente (o que o main faz) vai soltando a memoria.
 template<typename T> class ListNavigator;
 
-// Class List
 template<typename T> class List {
 private:
-    Node<T> *pHead;
-    Node<T> *pBack;
+    static const size_t TAM_BLOCO = sizeof(T) < 4096 ? 4096 / sizeof(T) : 1;
+
+    T** mapa;         // anel de blocos (nullptr = bloco sem nenhum item)
+    size_t numBlocos; // tamanho do anel
+    size_t inicio;    // onde ta o primeiro item (bloco * TAM_BLOCO + vaga)
     int numItems;
-    void succ(Node<T> *&p);
-    void pred(Node<T> *&p);
+
+    size_t capacidade() const { return numBlocos * TAM_BLOCO; }
+    size_t posicao(size_t i) const { return (inicio + i) % capacidade(); }
+    T* vaga(size_t p) const { return mapa[p / TAM_BLOCO] + p % TAM_BLOCO; }
+    const T& em(size_t i) const { return *vaga(posicao(i)); }
+    T* reservarVaga(size_t p);
+    void soltarBloco(size_t p);
+    void abrirEspaco();
+
+    friend class ListNavigator<T>;
 
 public:
-    void insertFront(T item);
-    void insertBack(T item);
+    void insertFront(const T& item) { emplaceFront(item); }
+    void insertFront(T&& item) { emplaceFront(std::move(item)); }
+    void insertBack(const T& item) { emplaceBack(item); }
+    void insertBack(T&& item) { emplaceBack(std::move(item)); }
+    // monta o item direto na vaga (sem temporario)
+    template <typename... Args>
+    void emplaceFront(Args&&... args);
+    template <typename... Args>
+    void emplaceBack(Args&&... args);
     void removeFront();
     void removeBack();
     T getItemFront();
     T getItemBack();
+    // tira o primeiro movendo (getItemFront + removeFront copiava a palavra)
+    T popFront();
     ListNavigator<T> getListNavigator() const;
     int size();
     bool empty();
     List();
-    Node<T>* getHead();
+    List(const List& outra);
+    List& operator=(List outra);
+    ~List();
+
+    // memoria dos blocos + mapa (pra comparar com um Node por item)
+    size_t bytesReservados() const;
 };
 
 template<typename T> List<T>::List()
 {
-    pHead = new Node<T>();
-    pBack = pHead;
-    pHead->next = nullptr;
+    mapa = nullptr;
+    numBlocos = 0;
+    inicio = 0;
     numItems = 0;
 }
 
-template<typename T> void List<T>::succ(Node<T> *&p) { p = p->next; }
+template<typename T> List<T>::List(const List& outra) : List()
+{
+    for (int i = 0; i < outra.numItems; i++) {
+        insertBack(outra.em(i));
+    }
+}
+
+template<typename T> List<T>& List<T>::operator=(List outra)
+{
+    std::swap(mapa, outra.mapa);
+    std::swap(numBlocos, outra.numBlocos);
+    std::swap(inicio, outra.inicio);
+    std::swap(numItems, outra.numItems);
+    return *this;
+}
 
-template<typename T> void List<T>::pred(Node<T> *&p)
+template<typename T> List<T>::~List()
 {
-    Node<T> *q = pHead;
-    while (q->next != p) {
-        succ(q);
+    for (int i = 0; i < numItems; i++) {
+        vaga(posicao(i))->~T();
     }
-    p = q;
+    for (size_t b = 0; b < numBlocos; b++) {
+        if (mapa[b] != nullptr) {
+            std::allocator<T>().deallocate(mapa[b], TAM_BLOCO);
+        }
+    }
+    delete[] mapa;
 }
 
-template<typename T> void List<T>::insertFront(T item)
+// sempre sobra pelo menos um bloco inteiro livre no anel: assim o comeco e o fim nunca
+// caem no mesmo bloco pelos dois lados, e crescer e so copiar os ponteiros em ordem
+template<typename T> void List<T>::abrirEspaco()
 {
-    Node<T> *pNew = new Node<T>(item);
-    pNew->next = pHead->next;
-    pHead->next = pNew;
-    pNew->prev = pHead;
+    if (static_cast<size_t>(numItems) + TAM_BLOCO < capacidade()) {
+        return;
+    }
+    size_t novos = numBlocos < 4 ? 4 : 2 * numBlocos;
+    T** novo = new T*[novos]();
+    if (numItems > 0) {
+        size_t primeiro = inicio / TAM_BLOCO;
+        size_t usados = (inicio % TAM_BLOCO + numItems + TAM_BLOCO - 1) / TAM_BLOCO;
+        for (size_t k = 0; k < usados; k++) {
+            novo[k] = mapa[(primeiro + k) % numBlocos];
+        }
+    }
+    inicio %= TAM_BLOCO;
+    delete[] mapa;
+    mapa = novo;
+    numBlocos = novos;
+}
 
-    if (pBack == pHead) {
-      pBack = pNew;
+template<typename T> T* List<T>::reservarVaga(size_t p)
+{
+    T*& bloco = mapa[p / TAM_BLOCO];
+    if (bloco == nullptr) {
+        bloco = std::allocator<T>().allocate(TAM_BLOCO);
     }
+    return bloco + p % TAM_BLOCO;
+}
+
+template<typename T> void List<T>::soltarBloco(size_t p)
+{
+    T*& bloco = mapa[p / TAM_BLOCO];
+    std::allocator<T>().deallocate(bloco, TAM_BLOCO);
+    bloco = nullptr;
+}
+
+template<typename T>
+template <typename... Args>
+void List<T>::emplaceFront(Args&&... args)
+{
+    abrirEspaco();
+    size_t p = (inicio + capacidade() - 1) % capacidade();
+    new (reservarVaga(p)) T(std::forward<Args>(args)...);
+    inicio = p; // so depois de construir: se o T jogar excecao a lista fica como tava
     numItems++;
 }
 
-template<typename T> void List<T>::insertBack(T item)
+template<typename T>
+template <typename... Args>
+void List<T>::emplaceBack(Args&&... args)
 {
-    Node<T> *pNew = new Node<T>(item);
-    pBack->next = pNew;
-    pNew->prev = pBack;
-    pBack = pNew;
+    abrirEspaco();
+    new (reservarVaga(posicao(numItems))) T(std::forward<Args>(args)...);
     numItems++;
 }
 
@@ -124,33 +202,29 @@ template<typename T> void List<T>::removeFront()
       return;
     }
 
-    Node<T> *temp = pHead->next;
-    pHead->next = temp->next;
-
-    if (pBack == temp) {
-      pBack = pHead;
-    }
-
-    delete temp;
+    size_t p = inicio;
+    vaga(p)->~T();
+    inicio = (inicio + 1) % capacidade();
     numItems--;
+    // era o ultimo do bloco (ou da lista): o bloco ficou vazio
+    if (numItems == 0 || p % TAM_BLOCO == TAM_BLOCO - 1) {
+        soltarBloco(p);
+    }
 }
 
 template<typename T> void List<T>::removeBack()
 {
     if (empty()) {
         cout << "List is empty" << endl;
+        return;
     }
 
-    Node<T> *temp = pBack;
-    pred(pBack);
-    pBack->next = nullptr;
-
-    delete temp;
-
-    if (pHead == pBack) {
-        pHead = pBack;
-    }
+    size_t p = posicao(numItems - 1);
+    vaga(p)->~T();
     numItems--;
+    if (numItems == 0 || p % TAM_BLOCO == 0) {
+        soltarBloco(p);
+    }
 }
 
 template<typename T> T List<T>::getItemFront()
@@ -159,7 +233,15 @@ template<typename T> T List<T>::getItemFront()
       return T();
     }
 
-    return pHead->next->getItem();
+    return *vaga(inicio);
+}
+
+template<typename T> T List<T>::popFront()
+{
+    // um return so (senao o compilador nao constroi item direto no retorno)
+    T item = empty() ? T() : std::move(*vaga(inicio));
+    removeFront(); // vazia: so avisa
+    return item;
 }
 
 template<typename T> T List<T>::getItemBack()
@@ -168,27 +250,34 @@ template<typename T> T List<T>::getItemBack()
       return T();
     }
 
-    return pBack->getItem();
+    return em(numItems - 1);
 }
 
 template<typename T> ListNavigator<T> List<T>::getListNavigator() const
 {
-    return ListNavigator<T>(pHead->next);
+    return ListNavigator<T>(this);
 }
 
 template<typename T> int List<T>::size(){
     return numItems;
 }
 
-template<typename T> bool List<T>::empty() { return pBack == pHead; }
+template<typename T> bool List<T>::empty() { return numItems == 0; }
 
-template<typename T> Node<T>* List<T>::getHead() { return pHead; }
+template<typename T> size_t List<T>::bytesReservados() const
+{
+    size_t blocos = 0;
+    for (size_t b = 0; b < numBlocos; b++) {
+        blocos += mapa[b] != nullptr;
+    }
+    return blocos * TAM_BLOCO * sizeof(T) + numBlocos * sizeof(T*);
+}
 
 // ListNavigator
+// anda pela posicao (0 = primeiro item); igual antes, nao pode mexer na lista enquanto navega
 template<typename T> class ListNavigator {
 private:
-    Node<T> *current;
-    Node<T> *start;
+    const List<T>* lista;
     int currentPosition;
 
 public:
@@ -197,62 +286,226 @@ public:
     void reset();
     bool getCurrentItem(T &item);
     int  getCurrentPosition() const;
-    ListNavigator(Node<T> *current);
+    explicit ListNavigator(const List<T>* lista);
     T getCurrentItem();
-    Node<T> *getCurrentNode() { return current; }
 };
 
-template<typename T> ListNavigator<T>::ListNavigator(Node<T> *current)
+template<typename T> ListNavigator<T>::ListNavigator(const List<T>* lista)
 {
-    this->current = current;
-    this->start = current;
+    this->lista = lista;
+    this->currentPosition = 0;
 }
 
-template<typename T> bool ListNavigator<T>::end() { return current == nullptr; }
+template<typename T> bool ListNavigator<T>::end() { return currentPosition >= lista->numItems; }
 
 template<typename T> void ListNavigator<T>::next() {
-        current = current->next;
+        currentPosition++;
 }
 
-template<typename T> void ListNavigator<T>::reset() { current = start; }
+template<typename T> void ListNavigator<T>::reset() { currentPosition = 0; }
 
 template<typename T> bool ListNavigator<T>::getCurrentItem (T &item)
 {
-    if (current == nullptr) {
+    if (end()) {
       return false;
     }
-    item = current->getItem();
+    item = lista->em(currentPosition);
     return true;
 }
 
-template<typename T> T ListNavigator<T>::getCurrentItem() { return current->getItem();}
+template<typename T> T ListNavigator<T>::getCurrentItem() { return lista->em(currentPosition);}
 
 template<typename T> int ListNavigator<T>::getCurrentPosition() const { return currentPosition; }
 
+// comparacao de 3 vias (<0, 0, >0): uma passada so por no em vez de < e depois >
+template <typename A, typename B>
+int comparar(const A& a, const B& b) {
+    if (a < b) return -1;
+    if (b < a) return 1;
+    return 0;
+}
+
+inline int comparar(const std::string& a, const std::string& b) {
+    return a.compare(b);
+}
+
+// busca heterogenea: pedaco de buffer contra a string guardada, sem criar temporario
+inline int comparar(std::string_view a, const std::string& b) {
+    return a.compare(b);
+}
+
+// view da chave pra hashear e pra consulta por prefixo sem copiar (qualquer tipo com
+// visaoChave pode ser usado pra buscar na tabela, tipo o is_transparent do unordered_set)
+inline std::string_view visaoChave(const std::string& item) { return item; }
+inline std::string_view visaoChave(std::string_view item) { return item; }
+inline std::string_view visaoChave(const char* item) { return item; }
+
+// ARENA DE NOS
+// Em vez de um new por palavra, os nos saem de blocos grandes (64 KiB) e os removidos
+// voltam numa lista de livres. O bloco e alinhado no proprio tamanho, entao da pra achar
+// o cabecalho dele a partir de qualquer no (pra marcar no mapa de vivos).
+// Destruir a arena libera tudo de uma vez: so roda destrutor de quem ta vivo
+// (e nem isso se o tipo for trivial) e da free nos blocos. Nao e thread-safe, mas
+// cada thread pode ter a sua: o no sempre volta pra arena dona do bloco dele.
+template <typename No>
+class ArenaNos {
+private:
+    static constexpr size_t TAM_BLOCO = 64 * 1024;
+
+    union Slot {
+        Slot* proximo; // quando ta livre
+        alignas(No) unsigned char dados[sizeof(No)];
+    };
+
+    // quantos slots cabem (o mapa de bits e dimensionado pelo maximo possivel)
+    static constexpr size_t MAX_SLOTS = TAM_BLOCO / sizeof(Slot);
+    static constexpr size_t PALAVRAS_MAPA = (MAX_SLOTS + 63) / 64;
+
+    struct Cabecalho {
+        ArenaNos* dono;
+        Cabecalho* anterior;
+        size_t usados; // slots ja entregues alguma vez (o resto nunca foi tocado)
+        uint64_t vivos[PALAVRAS_MAPA];
+    };
+
+    static constexpr size_t INICIO_SLOTS = (sizeof(Cabecalho) + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot);
+    static constexpr size_t SLOTS_POR_BLOCO = (TAM_BLOCO - INICIO_SLOTS) / sizeof(Slot);
+
+    Cabecalho* blocos = nullptr; // o ultimo e o que ta sendo preenchido
+    Slot* livres = nullptr;
+    size_t numBlocos = 0;
+    size_t numVivos = 0;
+
+    static Slot* slotsDe(Cabecalho* bloco) {
+        return reinterpret_cast<Slot*>(reinterpret_cast<unsigned char*>(bloco) + INICIO_SLOTS);
+    }
+    static Cabecalho* blocoDe(No* no) {
+        return reinterpret_cast<Cabecalho*>(reinterpret_cast<uintptr_t>(no) & ~(TAM_BLOCO - 1));
+    }
+
+    Slot* pegarSlot() {
+        if (livres != nullptr) {
+            Slot* s = livres;
+            livres = s->proximo;
+            return s;
+        }
+        if (blocos == nullptr || blocos->usados == SLOTS_POR_BLOCO) {
+            void* memoria = std::aligned_alloc(TAM_BLOCO, TAM_BLOCO);
+            if (memoria == nullptr) {
+                throw std::bad_alloc();
+            }
+            Cabecalho* novo = static_cast<Cabecalho*>(memoria);
+            novo->dono = this;
+            novo->anterior = blocos;
+            novo->usados = 0;
+            std::memset(novo->vivos, 0, sizeof(novo->vivos));
+            blocos = novo;
+            numBlocos++;
+        }
+        return &slotsDe(blocos)[blocos->usados++];
+    }
+
+    static void marcar(No* no, bool vivo) {
+        Cabecalho* bloco = blocoDe(no);
+        size_t i = reinterpret_cast<Slot*>(no) - slotsDe(bloco);
+        if (vivo) bloco->vivos[i / 64] |= uint64_t(1) << (i % 64);
+        else bloco->vivos[i / 64] &= ~(uint64_t(1) << (i % 64));
+    }
+
+public:
+    ArenaNos() = default;
+    ArenaNos(const ArenaNos&) = delete;
+    ArenaNos& operator=(const ArenaNos&) = delete;
+
+    ~ArenaNos() { clear(); }
+
+    template <typename... Args>
+    No* criar(Args&&... args) {
+        Slot* s = pegarSlot();
+        No* no;
+        try {
+            no = new (s->dados) No(std::forward<Args>(args)...);
+        } catch (...) {
+            s->proximo = livres;
+            livres = s;
+            throw;
+        }
+        marcar(no, true);
+        numVivos++;
+        return no;
+    }
+
+    // devolve o no pra arena de onde ele saiu (pode nao ser esta)
+    void liberar(No* no) {
+        ArenaNos* dono = blocoDe(no)->dono;
+        dono->marcar(no, false);
+        no->~No();
+        Slot* s = reinterpret_cast<Slot*>(no);
+        s->proximo = dono->livres;
+        dono->livres = s;
+        dono->numVivos--;
+    }
+
+    // solta tudo de uma vez (os nos viram lixo: quem apontava pra eles tem que esquecer)
+    void clear() {
+        while (blocos != nullptr) {
+            Cabecalho* anterior = blocos->anterior;
+            if constexpr (!std::is_trivially_destructible<No>::value) {
+                for (size_t w = 0; w < PALAVRAS_MAPA; w++) {
+                    uint64_t bits = blocos->vivos[w];
+                    while (bits != 0) {
+                        size_t i = w * 64 + __builtin_ctzll(bits);
+                        reinterpret_cast<No*>(slotsDe(blocos)[i].dados)->~No();
+                        bits &= bits - 1;
+                    }
+                }
+            }
+            std::free(blocos);
+            blocos = anterior;
+        }
+        livres = nullptr;
+        numBlocos = 0;
+        numVivos = 0;
+    }
+
+    size_t vivos() const { return numVivos; }
+    size_t bytesReservados() const { return numBlocos * TAM_BLOCO; }
+    size_t bytesVivos() const { return numVivos * sizeof(No); }
+};
+
 // Nó da Árvore Binária de Busca (BST)
 template <typename T>
 class BSTNode {
 private:
-    T item;
     BSTNode<T>* left;
     BSTNode<T>* right;
     BSTNode<T>* parent;
     int height;
+    int tamanho; // nos na subarvore dele (ele incluso): rank/select em O(log n)
+    T item; // por ultimo: chave pequena (ChaveInterna) fica colada no resto
 
 public:
-    explicit BSTNode(T item) : item(item), left(nullptr), right(nullptr), parent(nullptr), height(1) {}
-    T getItem() const { return item; }
-    void setItem(T val) { item = val; }
+    // K = T ou algo que constroi T (string_view -> string so quando o no e criado)
+    // (rvalue chega movido: a palavra nao e copiada de novo pra dentro do no)
+    template <typename K>
+    explicit BSTNode(K&& item)
+        : left(nullptr), right(nullptr), parent(nullptr), height(1), tamanho(1), item(std::forward<K>(item)) {}
+    const T& getItem() const { return item; } // referencia: comparar nao copia a string
+    void setItem(const T& val) { item = val; }
+    void setItem(T&& val) { item = std::move(val); }
+    T&& soltarItem() { return std::move(item); } // so pra quem vai liberar o no logo depois
 
     BSTNode<T>* getLeft() const { return left; }
     BSTNode<T>* getRight() const { return right; }
     BSTNode<T>* getParent() const { return parent; }
     int getHeight() const { return height; }
+    int getTamanho() const { return tamanho; }
 
     void setLeft(BSTNode<T>* node);
     void setRight(BSTNode<T>* node);
     void setParent(BSTNode<T>* node) { parent = node; }
     void setHeight(int h) { height = h; }
+    void setTamanho(int t) { tamanho = t; }
 };
 
 template <typename T>
@@ -273,13 +526,38 @@ void BSTNode<T>::setRight(BSTNode<T>* node) {
 
 
 
+// ESTATISTICAS (compilar com -DCOM_ESTATISTICAS): sem a flag tudo que esta dentro de
+// SO_ESTATISTICA some na compilacao, entao a versao normal nao paga nada (nem um campo
+// a mais nas classes). Com a flag cada arvore conta as proprias sondagens, rotacoes e a
+// soma das profundidades dos nos (raiz = 1), e a HashTable junta tudo (ver EstatisticasTabela)
+#ifdef COM_ESTATISTICAS
+#define SO_ESTATISTICA(...) __VA_ARGS__
+
+struct ContadoresArvore {
+    uint64_t sondagens = 0;        // nos visitados nas buscas
+    uint64_t rotacoes = 0;         // simples; a dupla conta 2
+    int64_t somaProfundidades = 0; // media = soma / itens
+};
+
+// nos criados e liberados um a um (os que somem com a arena inteira nao passam aqui)
+struct ContagemNos {
+    static inline std::atomic<uint64_t> criados{0};
+    static inline std::atomic<uint64_t> liberados{0};
+};
+#else
+#define SO_ESTATISTICA(...)
+#endif
+
 // Classe da Árvore Binária de Busca (BST)
 template <typename T>
 class BST {
 private:
     BSTNode<T>* root;
+    ArenaNos<BSTNode<T>>* arena; // de onde saem os nos (nullptr = new/delete normal)
 
-    BSTNode<T>* SearchHelper(const T& item, BSTNode<T>* node);
+    template <typename K>
+    BSTNode<T>* novoNo(K&& item);
+    void liberarNo(BSTNode<T>* node);
 
     // Coisas de AVL
     int getBalanceFactor(BSTNode<T>* node) const;
@@ -287,42 +565,238 @@ private:
     BSTNode<T>* leftRotate(BSTNode<T>* node_x);
     BSTNode<T>* rebalance(BSTNode<T>* node);
 
-    // Calculadora de altura
+    // Calculadora de altura (e do tamanho da subarvore junto)
     void calculateHeight(BSTNode<T>* node);
+    void calcularTamanho(BSTNode<T>* node);
+    static int getNodeTamanho(const BSTNode<T>* node) { return node == nullptr ? 0 : node->getTamanho(); }
+
+    // 'antes' diz se o item fica antes do que se procura; tem que ser verdade pra um
+    // comeco da ordem e falso pro resto (ex: item < chave). Uma descida so.
+    template <typename F>
+    int ContarAntes(F antes) const; // quantos itens dao verdade
+    template <typename F>
+    BSTNode<T>* PrimeiroDepois(F antes) const; // primeiro que da falso (ou nullptr)
 
     void ProcessNode(BSTNode<T>* node);
-    void PreOrderHelper(BSTNode<T>* node);
-    void CentralOrderHelper(BSTNode<T>* node);
-    void PostOrderHelper(BSTNode<T>* node);
 
-    BSTNode<T>* InsertHelper(BSTNode<T>* currentNode, const T& item);
-    BSTNode<T>* RemoveHelper(BSTNode<T>* currentNode, const T& item);
+    // Andar pela arvore usando os ponteiros de pai: nenhum percurso tem recursao nem
+    // pilha, entao o custo de pilha e fixo nao importa o formato da arvore.
+    // 'topo' e onde o percurso para (a raiz da subarvore que ta sendo percorrida).
+    static BSTNode<T>* maisEsquerda(BSTNode<T>* node);
+    static BSTNode<T>* proximoEmOrdem(BSTNode<T>* node); // so na arvore inteira (pai da raiz = nullptr)
+    static BSTNode<T>* proximoPreOrdem(BSTNode<T>* node, const BSTNode<T>* topo);
+    static BSTNode<T>* primeiroPosOrdem(BSTNode<T>* node);
+    static BSTNode<T>* proximoPosOrdem(BSTNode<T>* node, const BSTNode<T>* topo);
+
+    // insere embaixo na descida e sobe pelos pais rebalanceando; devolve o no que
+    // ficou com a chave (o novo, ou o que ja tinha ela)
+    template <typename K>
+    BSTNode<T>* InsertHelper(K&& item, BSTNode<T>* novo = nullptr);
+    void subirRebalanceando(BSTNode<T>* node, int delta); // delta: +1 insert, -1 remove
 
     int getNodeHeight(BSTNode<T>* node) const;
     void destroy(BSTNode<T>* node);
 
+    // pos-ordem que ja leu o proximo antes de entregar o no (destino pode liberar ou reusar ele)
+    template <typename F>
+    void SoltarPosOrdem(BSTNode<T>* topo, F& destino);
+
+    template <typename It>
+    BSTNode<T>* ConstruirHelper(It inicio, It fim); // arvore sai balanceada: log n de fundura
+
+    // como o Insert/Remove/Search eram antes de virar descida com ponteiro de pai:
+    // recursao que devolve a subarvore nova e rebalanceia em todo nivel na volta.
+    // So o --bench-arvore usa (pra comparar com a iterativa no mesmo binario)
+    template <typename K>
+    BSTNode<T>* InsertRecursivoHelper(BSTNode<T>* node, const K& item, int64_t profundidade);
+    BSTNode<T>* RemoveRecursivoHelper(BSTNode<T>* node, const T& item, int64_t profundidade);
+    template <typename K>
+    BSTNode<T>* SearchRecursivoHelper(const K& item, BSTNode<T>* node);
+
+    int numNos; // quantos itens tem na arvore
+#ifdef COM_ESTATISTICAS
+    ContadoresArvore contagem;
+    // profundidade de todo mundo de uma vez: cada no conta 1 pra ele e pra cada ancestral
+    void recontarProfundidades() { contagem.somaProfundidades = SomarProfundidades(); }
+#endif
+
 public:
-    BST() : root(nullptr) {}
+    typedef ArenaNos<BSTNode<T>> Arena; // a HashTable cria a arena da gaveta por aqui
+
+    explicit BST(ArenaNos<BSTNode<T>>* arena = nullptr) : root(nullptr), arena(arena), numNos(0) {}
+    // troca de onde os proximos nos vao sair (os que ja existem voltam pra arena deles)
+    void setArena(ArenaNos<BSTNode<T>>* nova) { arena = nova; }
     ~BST();
     BSTNode<T>* getRoot() const { return root; } // so existe pq tem q medir a altura a partir da raizz da arvore aparentemente
 
-    BSTNode<T>* Search(const T& item);
-    void PreOrder() { PreOrderHelper(root); }
-    void CentralOrder() { CentralOrderHelper(root); }
-    void PostOrder() { PostOrderHelper(root); }
-
-    void Insert(const T& item);
+    // K pode ser T ou qualquer coisa que o comparar() aceite contra T (ex: string_view)
+    template <typename K>
+    BSTNode<T>* Search(const K& item);
+    void PreOrder();
+    void CentralOrder();
+    void PostOrder();
+
+    // igual ao Search: pode inserir por string_view, o T so e montado se a chave for nova
+    // (T rvalue e movido pro no; se ja existia, nao vira nada)
+    template <typename K>
+    void Insert(K&& item);
+    // mesma descida do Insert, mas devolve o item que ficou na arvore (o novo ou o que
+    // ja existia), pra quem quer mexer no valor (modo mapa) sem descer de novo
+    template <typename K>
+    const T& InsertOuAcha(K&& item) { return InsertHelper(std::forward<K>(item))->getItem(); }
+    void InsertNode(BSTNode<T>* node); // reaproveita um no ja alocado (usado no rehash)
 
     void Remove(const T &item);
 
+    // solta todos os nos (pos-ordem) e entrega cada um pro destino, arvore fica vazia
+    template <typename F>
+    void Esvaziar(F destino);
+
+    int size() const { return numNos; }
+
+    // Monta a arvore direto a partir de itens ja ordenados e sem repeticao, em O(n):
+    // o do meio vira raiz e cada metade vira uma subarvore, entao as alturas dos dois
+    // lados diferem no maximo 1 (continua valendo a regra do AVL). Troca o conteudo atual.
+    template <typename It>
+    void CarregarOrdenado(It inicio, It fim);
+    // Monta a arvore com uma forma ja pronta (a do snapshot): n nos em pre-ordem,
+    // chave(i) da o que monta o i-esimo e filhos(i) o par de indices dos filhos dele
+    // (-1 = nao tem, e filho sempre vem depois do pai). Sem comparacao nem rotacao.
+    template <typename FChave, typename FFilhos>
+    void CarregarForma(int n, FChave chave, FFilhos filhos);
+
+    // ITERADOR EM ORDEM: so um ponteiro pro no atual, o ++ anda pelos pais
+    // (proximoEmOrdem), entao nao aloca nada. Vale ate a proxima mudanca na arvore.
+    class const_iterator {
+    private:
+        BSTNode<T>* node;
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T* pointer;
+        typedef const T& reference;
+
+        explicit const_iterator(BSTNode<T>* node = nullptr) : node(node) {}
+        const T& operator*() const { return node->getItem(); }
+        const T* operator->() const { return &node->getItem(); }
+        const_iterator& operator++() {
+            node = proximoEmOrdem(node);
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator antes = *this;
+            ++*this;
+            return antes;
+        }
+        bool operator==(const const_iterator& outro) const { return node == outro.node; }
+        bool operator!=(const const_iterator& outro) const { return node != outro.node; }
+    };
+    const_iterator begin() const { return const_iterator(maisEsquerda(root)); }
+    const_iterator end() const { return const_iterator(); }
+
+    // visita os itens em ordem sem imprimir nada
+    template <typename F>
+    void EmOrdem(F visitar) const {
+        for (BSTNode<T>* node = maisEsquerda(root); node != nullptr; node = proximoEmOrdem(node)) {
+            visitar(node->getItem());
+        }
+    }
+    // pre-ordem entregando o no (da pra comparar o formato de duas arvores)
+    template <typename F>
+    void EmPreOrdem(F visitar) const {
+        for (BSTNode<T>* node = root; node != nullptr; node = proximoPreOrdem(node, root)) {
+            visitar(*node);
+        }
+    }
+
+    // ESTATISTICA DE ORDEM, tudo O(log n) usando o tamanho das subarvores.
+    // K e qualquer coisa que o comparar() aceite contra T (igual o Search)
+    template <typename K>
+    int Rank(const K& chave) const; // quantos itens < chave
+    const T* Select(int i) const;   // o i-esimo menor (0 = menor), nullptr se nao tiver
+    template <typename K1, typename K2>
+    int CountRange(const K1& de, const K2& ate) const; // de <= item <= ate
+    int CountPrefix(std::string_view prefixo) const;  // itens que comecam com prefixo
+    // visita em ordem so os itens da faixa (sem passar pelos outros)
+    template <typename K1, typename K2, typename F>
+    void EmFaixa(const K1& de, const K2& ate, F visitar) const;
+    template <typename F>
+    void EmPrefixo(std::string_view prefixo, F visitar) const;
+
+    // confere ordem, alturas, tamanhos e fator de balanceamento de todos os nos
+    bool ConferirAVL() const;
+
+    // versao recursiva antiga (referencia do --bench-arvore): da a mesma arvore
+    template <typename K>
+    void InsertRecursivo(const K& item) {
+        root = InsertRecursivoHelper(root, item, 1);
+        root->setParent(nullptr);
+    }
+    void RemoveRecursivo(const T& item) {
+        root = RemoveRecursivoHelper(root, item, 1);
+        if (root != nullptr) root->setParent(nullptr);
+    }
+    template <typename K>
+    BSTNode<T>* SearchRecursivo(const K& item) { return SearchRecursivoHelper(item, root); }
+
+    // esquece os nos sem liberar um por um: so pode quando a arena vai ser limpa inteira
+    void Abandonar() {
+        root = nullptr;
+        numNos = 0;
+        SO_ESTATISTICA(contagem.somaProfundidades = 0;)
+    }
+
     void generateDot(BSTNode<T> *node, std::ostream &out);
 
     void drawTree(BSTNode<T> *root);
+
+#ifdef COM_ESTATISTICAS
+    const ContadoresArvore& contadores() const { return contagem; }
+    // percorre a arvore (pra conferir a soma mantida operacao por operacao)
+    int64_t SomarProfundidades() const {
+        int64_t soma = 0;
+        EmPreOrdem([&soma](const BSTNode<T>& node) { soma += node.getTamanho(); });
+        return soma;
+    }
+#endif
+
+    // o que a HashTable usa sem saber qual balde e
+    int altura() const { return root != nullptr ? root->getHeight() : 0; }
+    void desenhar() { drawTree(root); }
+    static const T& itemDo(const BSTNode<T>* node) { return node->getItem(); } // no que saiu no Esvaziar
 };
 
+template <typename T>
+template <typename K>
+BSTNode<T>* BST<T>::novoNo(K&& item) {
+    SO_ESTATISTICA(ContagemNos::criados.fetch_add(1, std::memory_order_relaxed);)
+    if (arena != nullptr) {
+        return arena->criar(std::forward<K>(item));
+    }
+    return new BSTNode<T>(std::forward<K>(item));
+}
+
+template <typename T>
+void BST<T>::liberarNo(BSTNode<T>* node) {
+    if (node == nullptr) return;
+    SO_ESTATISTICA(ContagemNos::liberados.fetch_add(1, std::memory_order_relaxed);)
+    if (arena != nullptr) {
+        arena->liberar(node);
+    } else {
+        delete node;
+    }
+}
+
 template<typename T>
 void BST<T>::calculateHeight(BSTNode<T>* node) {
     node->setHeight(1 + fmax(getNodeHeight(node->getLeft()), getNodeHeight(node->getRight())));
+    calcularTamanho(node); // muda nos mesmos lugares (rotacao, rebalance, construcao)
+}
+
+template<typename T>
+void BST<T>::calcularTamanho(BSTNode<T>* node) {
+    node->setTamanho(1 + getNodeTamanho(node->getLeft()) + getNodeTamanho(node->getRight()));
 }
 
 
@@ -335,11 +809,61 @@ int BST<T>::getNodeHeight(BSTNode<T>* node) const {
 }
 
 template <typename T>
-BSTNode<T>* BST<T>::SearchHelper(const T& item, BSTNode<T>* node) {
+BSTNode<T>* BST<T>::maisEsquerda(BSTNode<T>* node) {
     if (node == nullptr) return nullptr;
-    if (item < node->getItem()) return SearchHelper(item, node->getLeft());
-    else if (item > node->getItem()) return SearchHelper(item, node->getRight());
-    else return node;
+    while (node->getLeft() != nullptr) {
+        node = node->getLeft();
+    }
+    return node;
+}
+
+template <typename T>
+BSTNode<T>* BST<T>::proximoEmOrdem(BSTNode<T>* node) {
+    if (node->getRight() != nullptr) {
+        return maisEsquerda(node->getRight());
+    }
+    // sobe ate chegar num pai pela esquerda
+    BSTNode<T>* pai = node->getParent();
+    while (pai != nullptr && node == pai->getRight()) {
+        node = pai;
+        pai = pai->getParent();
+    }
+    return pai;
+}
+
+template <typename T>
+BSTNode<T>* BST<T>::proximoPreOrdem(BSTNode<T>* node, const BSTNode<T>* topo) {
+    if (node->getLeft() != nullptr) return node->getLeft();
+    if (node->getRight() != nullptr) return node->getRight();
+    // folha: sobe ate um pai que ainda tem o lado direito pra visitar
+    while (node != topo) {
+        BSTNode<T>* pai = node->getParent();
+        if (pai->getLeft() == node && pai->getRight() != nullptr) {
+            return pai->getRight();
+        }
+        node = pai;
+    }
+    return nullptr;
+}
+
+template <typename T>
+BSTNode<T>* BST<T>::primeiroPosOrdem(BSTNode<T>* node) {
+    if (node == nullptr) return nullptr;
+    while (true) {
+        if (node->getLeft() != nullptr) node = node->getLeft();
+        else if (node->getRight() != nullptr) node = node->getRight();
+        else return node;
+    }
+}
+
+template <typename T>
+BSTNode<T>* BST<T>::proximoPosOrdem(BSTNode<T>* node, const BSTNode<T>* topo) {
+    if (node == topo) return nullptr;
+    BSTNode<T>* pai = node->getParent();
+    if (pai->getLeft() == node && pai->getRight() != nullptr) {
+        return primeiroPosOrdem(pai->getRight());
+    }
+    return pai;
 }
 
 template <typename T>
@@ -360,82 +884,118 @@ void BST<T>::ProcessNode(BSTNode<T>* node) {
 }
 
 template <typename T>
-void BST<T>::PreOrderHelper(BSTNode<T>* node) {
-    if (node == nullptr) return;
-    ProcessNode(node);
-    PreOrderHelper(node->getLeft());
-    PreOrderHelper(node->getRight());
+void BST<T>::PreOrder() {
+    for (BSTNode<T>* node = root; node != nullptr; node = proximoPreOrdem(node, root)) {
+        ProcessNode(node);
+    }
 }
 
 template <typename T>
-void BST<T>::CentralOrderHelper(BSTNode<T>* node) {
-    if (node == nullptr) return;
-    CentralOrderHelper(node->getLeft());
-    ProcessNode(node);
-    CentralOrderHelper(node->getRight());
+void BST<T>::CentralOrder() {
+    for (BSTNode<T>* node = maisEsquerda(root); node != nullptr; node = proximoEmOrdem(node)) {
+        ProcessNode(node);
+    }
 }
 
 template <typename T>
-void BST<T>::PostOrderHelper(BSTNode<T>* node) {
-    if (node == nullptr) return;
-    PostOrderHelper(node->getLeft());
-    PostOrderHelper(node->getRight());
-    ProcessNode(node);
+void BST<T>::PostOrder() {
+    for (BSTNode<T>* node = primeiroPosOrdem(root); node != nullptr; node = proximoPosOrdem(node, root)) {
+        ProcessNode(node);
+    }
 }
 
 template <typename T>
-BSTNode<T>* BST<T>::InsertHelper(BSTNode<T>* currentNode, const T& item) {
-    if (currentNode == nullptr) {
-        return new BSTNode<T>(item);
+template <typename K>
+BSTNode<T>* BST<T>::InsertHelper(K&& item, BSTNode<T>* novo) {
+    if (root == nullptr) {
+        root = novo != nullptr ? novo : novoNo(std::forward<K>(item));
+        root->setParent(nullptr);
+        numNos++;
+        SO_ESTATISTICA(contagem.somaProfundidades += 1;)
+        return root;
     }
-    if (item < currentNode->getItem()) currentNode->setLeft(InsertHelper(currentNode->getLeft(), item));
-    else if (item > currentNode->getItem()) currentNode->setRight(InsertHelper(currentNode->getRight(), item));
-    else {
-        return currentNode;
+    // desce ate o lugar vago
+    BSTNode<T>* node = root;
+    SO_ESTATISTICA(int64_t profundidade = 1;) // a do node
+    while (true) {
+        int cmp = comparar(item, node->getItem());
+        if (cmp == 0) {
+            liberarNo(novo); // ja existia, o no que veio de fora sobra
+            return node;
+        }
+        BSTNode<T>* filho = cmp < 0 ? node->getLeft() : node->getRight();
+        if (filho == nullptr) {
+            BSTNode<T>* criado = novo != nullptr ? novo : novoNo(std::forward<K>(item));
+            if (cmp < 0) node->setLeft(criado);
+            else node->setRight(criado);
+            numNos++;
+            SO_ESTATISTICA(contagem.somaProfundidades += profundidade + 1;)
+            // depois de tudo, bota pra balancear (do pai do novo ate a raiz).
+            // rotacao so religa nos, o item continua no mesmo no
+            subirRebalanceando(node, 1);
+            return criado;
+        }
+        node = filho;
+        SO_ESTATISTICA(profundidade++;)
     }
-
-    // depois de tudo, bota pra balancear
-    return rebalance(currentNode);
 }
 
+// rebalanceia do node ate a raiz, religando cada subarvore no pai. Para quando a
+// altura da subarvore volta a ser a de antes: dali pra cima nenhum fator muda
+// (o rebalance nesses pais nao faria nada, igual na versao recursiva)
 template <typename T>
-BSTNode<T>* BST<T>::RemoveHelper(BSTNode<T>* currentNode, const T& item) {
-    if (currentNode == nullptr) return nullptr;
-    if (item < currentNode->getItem()) currentNode->setLeft(RemoveHelper(currentNode->getLeft(), item));
-    else if (item > currentNode->getItem()) currentNode->setRight(RemoveHelper(currentNode->getRight(), item));
-    else{
-        // Caso 1: Nó sem filho esquerdo
-        if (currentNode->getLeft() == nullptr) {
-            BSTNode<T>* temp = currentNode->getRight();
-            delete currentNode;
-            return temp; // Retorna o filho direito para ser ligado ao pai do nó removido
-        }
-        // Caso 2: Nó sem filho direito
-        else if (currentNode->getRight() == nullptr) {
-            BSTNode<T>* temp =  currentNode->getLeft();
-            delete currentNode;
-            return temp; // Retorna o filho esquerdo
+void BST<T>::subirRebalanceando(BSTNode<T>* node, int delta) {
+    while (node != nullptr) {
+        BSTNode<T>* pai = node->getParent();
+        int alturaAntes = node->getHeight();
+        BSTNode<T>* topo = rebalance(node);
+        if (pai == nullptr) {
+            root = topo;
+            topo->setParent(nullptr);
+        } else if (pai->getLeft() == node) {
+            pai->setLeft(topo);
+        } else {
+            pai->setRight(topo);
         }
-        // Caso 3: Nó com dois filhos
-        BSTNode<T>* successor = currentNode->getRight();
-        while (successor->getLeft() != nullptr) {
-            successor = successor->getLeft();
+        if (topo->getHeight() == alturaAntes) {
+            // dali pra cima a altura nao muda mais, mas o tamanho muda ate a raiz
+            // (so soma: recalcular leria o irmao de cada um, que nao ta no cache)
+            for (; pai != nullptr; pai = pai->getParent()) {
+                pai->setTamanho(pai->getTamanho() + delta);
+            }
+            break;
         }
-        // Copia o item do sucessor para este nó e remove o sucessor da subárvore direita
-        currentNode->setItem(successor->getItem());
-        currentNode->setRight(RemoveHelper(currentNode->getRight(), successor->getItem()));
+        node = pai;
     }
+}
 
-    // depois de tudo, bota pra balancear
-    return rebalance(currentNode);
+template <typename T>
+template <typename F>
+void BST<T>::SoltarPosOrdem(BSTNode<T>* topo, F& destino) {
+    BSTNode<T>* node = primeiroPosOrdem(topo);
+    while (node != nullptr) {
+        // o pai ainda nao foi entregue (pos-ordem), so o node pode sumir
+        BSTNode<T>* proximo = proximoPosOrdem(node, topo);
+        destino(node);
+        node = proximo;
+    }
 }
 
+// aqui a ordem nao importa: pilha de tamanho fixo em vez de andar pelos pais (assim
+// os dois filhos ja sao pedidos juntos e a memoria nao fica esperando um por um).
+// Cabe sempre: a pilha nunca passa de altura + 1, e uma AVL de altura 128 nao existe.
 template <typename T>
 void BST<T>::destroy(BSTNode<T>* node) {
     if (node == nullptr) return;
-    destroy(node->getLeft());
-    destroy(node->getRight());
-    delete node;
+    BSTNode<T>* pilha[128];
+    int topo = 0;
+    pilha[topo++] = node;
+    while (topo > 0) {
+        BSTNode<T>* atual = pilha[--topo];
+        if (atual->getRight() != nullptr) pilha[topo++] = atual->getRight();
+        if (atual->getLeft() != nullptr) pilha[topo++] = atual->getLeft();
+        liberarNo(atual);
+    }
 }
 
 template<typename T>
@@ -452,6 +1012,9 @@ int BST<T>::getBalanceFactor(BSTNode<T> *node) const {
 template <typename T>
 BSTNode<T>* BST<T>::rightRotate(BSTNode<T>* node) {
     BSTNode<T>* x = node->getLeft(); // o que vai subir: node vai ocupar o lado direito dele
+    // a esquerda do x sobe um nivel e a direita do node desce um (x e node trocam entre si)
+    SO_ESTATISTICA(contagem.rotacoes++;
+                   contagem.somaProfundidades += getNodeTamanho(node->getRight()) - getNodeTamanho(x->getLeft());)
     // com isso, o lado esquerdo do node vai ficar vago
 
     BSTNode<T>* orfao = x->getRight(); // a subarvore q esta no lado direito
@@ -480,6 +1043,8 @@ BSTNode<T> *BST<T>::leftRotate(BSTNode<T>* node) {
 
     BSTNode<T>* x = node->getRight(); // o que vai subir
     BSTNode<T>* orfao = x->getLeft(); // o orfao
+    SO_ESTATISTICA(contagem.rotacoes++;
+                   contagem.somaProfundidades += getNodeTamanho(node->getLeft()) - getNodeTamanho(x->getRight());)
 
     // botamo o node no lugar do orfao -> direitinha
     x->setLeft(node);
@@ -556,197 +1121,5850 @@ BST<T>::~BST() {
 }
 
 template <typename T>
-BSTNode<T>* BST<T>::Search(const T& item) {
-    return SearchHelper(item, root);
+template <typename K>
+BSTNode<T>* BST<T>::Search(const K& item) {
+    BSTNode<T>* node = root;
+    while (node != nullptr) {
+        SO_ESTATISTICA(contagem.sondagens++;)
+        int cmp = comparar(item, node->getItem());
+        if (cmp < 0) node = node->getLeft();
+        else if (cmp > 0) node = node->getRight();
+        else return node;
+    }
+    return nullptr;
 }
 
 template <typename T>
-void BST<T>::Insert(const T& item) {
-    root = InsertHelper(root, item);
-    if (root != nullptr) {
-        root->setParent(nullptr);
-    }
+template <typename K>
+void BST<T>::Insert(K&& item) {
+    InsertHelper(std::forward<K>(item));
 }
 
 template <typename T>
-void BST<T>::Remove(const T &item) {
-    root = RemoveHelper(root, item);
-    if (root != nullptr) {
-        root->setParent(nullptr);
-    }
-/*por algum motivo isso aqui sempre retorna false mesmo quando funciona
-pq???
-mas no fim das contas o remove nem vai ser usado no final entao n deve ser prioridade consertar isso
-mas sla seria meio estranho enviar o trabalho terminado com isso funcionando errado
-o importante e o q importa
+void BST<T>::InsertNode(BSTNode<T>* node) {
+    InsertHelper(node->getItem(), node);
+}
 
-EDIT: por via das duvidas, transformei em void, meio que nem é necessario devolver nada
-*/
+template <typename T>
+template <typename F>
+void BST<T>::Esvaziar(F destino) {
+    BSTNode<T>* antigo = root;
+    root = nullptr;
+    numNos = 0;
+    SO_ESTATISTICA(contagem.somaProfundidades = 0;)
+    auto soltar = [&destino](BSTNode<T>* node) {
+        // no sai limpinho, como se tivesse acabado de ser criado
+        node->setLeft(nullptr);
+        node->setRight(nullptr);
+        node->setParent(nullptr);
+        node->setHeight(1);
+        node->setTamanho(1);
+        destino(node);
+    };
+    SoltarPosOrdem(antigo, soltar);
+}
+
+template <typename T>
+template <typename It>
+BSTNode<T>* BST<T>::ConstruirHelper(It inicio, It fim) {
+    if (inicio == fim) return nullptr;
+    It meio = inicio + (fim - inicio) / 2;
+    BSTNode<T>* node = novoNo(*meio);
+    node->setLeft(ConstruirHelper(inicio, meio));
+    node->setRight(ConstruirHelper(meio + 1, fim));
+    calculateHeight(node);
+    return node;
+}
 
+template <typename T>
+template <typename It>
+void BST<T>::CarregarOrdenado(It inicio, It fim) {
+    destroy(root);
+    root = ConstruirHelper(inicio, fim);
+    numNos = static_cast<int>(fim - inicio);
+    SO_ESTATISTICA(recontarProfundidades();)
 }
 
-// DESENHADOR DE AUTOMATO
 template <typename T>
-void BST<T>::generateDot(BSTNode<T>* node, std::ostream& out) {
-    if (node == nullptr) {
-        return;
-    }
-    // Adiciona o nó atual com a altura
-    out << "    " << node->getItem() << " [label=\"" << node->getItem() << "\\nAltura: " << node->getHeight() << "\"];\n";
-    // Conecta o nó atual aos filhos
-    if (node->getLeft() != nullptr) {
-        out << "    " << node->getItem() << " -> " << node->getLeft()->getItem() << ";\n";
+template <typename FChave, typename FFilhos>
+void BST<T>::CarregarForma(int n, FChave chave, FFilhos filhos) {
+    destroy(root);
+    root = nullptr;
+    numNos = 0;
+    SO_ESTATISTICA(contagem.somaProfundidades = 0;)
+    if (n <= 0) return;
+    vector<BSTNode<T>*> nos(n);
+    for (int i = 0; i < n; i++) {
+        nos[i] = novoNo(chave(i));
     }
-    if (node->getRight()) {
-        out << "    " << node->getItem() << " -> " << node->getRight()->getItem() << ";\n";
-        // Chama recursivamente para os filhos
-        generateDot(node->getLeft(), out);
-        generateDot(node->getRight(), out);
+    // de tras pra frente: quando chega no pai os filhos ja tem altura e tamanho certos
+    for (int i = n - 1; i >= 0; i--) {
+        std::pair<int, int> f = filhos(i);
+        if (f.first >= 0) nos[i]->setLeft(nos[f.first]);
+        if (f.second >= 0) nos[i]->setRight(nos[f.second]);
+        calculateHeight(nos[i]);
     }
+    root = nos[0];
+    numNos = n;
+    SO_ESTATISTICA(recontarProfundidades();)
 }
 
 template <typename T>
-void BST<T>::drawTree(BSTNode<T>* root) {
-    std::cout << "digraph G {\n";
-    generateDot(root, std::cout);
-    std::cout << "}\n";
+bool BST<T>::ConferirAVL() const {
+    bool ok = root == nullptr || root->getParent() == nullptr;
+    // pos-ordem: quando chega no node os filhos ja foram conferidos, entao a altura
+    // guardada neles e a real
+    for (BSTNode<T>* node = primeiroPosOrdem(root); node != nullptr; node = proximoPosOrdem(node, root)) {
+        BSTNode<T>* esq = node->getLeft();
+        BSTNode<T>* dir = node->getRight();
+        if (esq != nullptr && (esq->getParent() != node || !(comparar(esq->getItem(), node->getItem()) < 0))) ok = false;
+        if (dir != nullptr && (dir->getParent() != node || !(comparar(dir->getItem(), node->getItem()) > 0))) ok = false;
+        if (node->getHeight() != 1 + max(getNodeHeight(esq), getNodeHeight(dir))) ok = false;
+        if (node->getTamanho() != 1 + getNodeTamanho(esq) + getNodeTamanho(dir)) ok = false;
+        if (getBalanceFactor(node) < -1 || getBalanceFactor(node) > 1) ok = false;
+    }
+    // ordem global: em ordem tem que sair crescente
+    const T* anterior = nullptr;
+    EmOrdem([&](const T& item) {
+        if (anterior != nullptr && !(comparar(*anterior, item) < 0)) ok = false;
+        anterior = &item;
+    });
+    return ok && getNodeTamanho(root) == numNos;
 }
 
-// Hash Table
 template <typename T>
-class HashTable {
-private:
-    BST<T>** tabela;
-    // edit
-    // motivo do ponteiro de ponteiro: qnd e ponteiro demora mt mais
-
-    //mudei de ponteiro de ponteiro pra ponteiro unico pq era meio desnecessario
-    //remover comentario depois
-    //ou nao
-    //alguem vai ler isso depois pode ser engracado seila
-    //diminuir nossa nota nao vai
-    //comentarios contam uma historia
-    size_t Hash(const T& item);
-    size_t SIZE = 151;
-public:
-    void insert(T item);
-    void remove(T item); //na teoria nao precisa remover nada pra fazer o que precisa no hackerrank..
-    //mas agora vou tentar fazer funcionar
-    bool search(T item); // to fazendo retornar o proprio nó
-    int length();
-    bool empty();
-
-    auto buscarMostrarAltura(T key);
-
-    HashTable() {
-        tabela = new BST<T>*[SIZE];
-
-        // deixar geral nullptr para existir as 'gavetas'
-        for (int i = 0; i < SIZE; i++) {
-            tabela[i] = nullptr;
+template <typename F>
+int BST<T>::ContarAntes(F antes) const {
+    int total = 0;
+    BSTNode<T>* node = root;
+    while (node != nullptr) {
+        if (antes(node->getItem())) {
+            // ele e a subarvore esquerda inteira ficam antes
+            total += getNodeTamanho(node->getLeft()) + 1;
+            node = node->getRight();
+        } else {
+            node = node->getLeft();
         }
     }
-    ~HashTable() {
-        for (int i = 0; i < SIZE; i++) {
-            if (tabela[i] != nullptr) {
-                delete tabela[i];
-            }
+    return total;
+}
+
+template <typename T>
+template <typename F>
+BSTNode<T>* BST<T>::PrimeiroDepois(F antes) const {
+    BSTNode<T>* achado = nullptr;
+    BSTNode<T>* node = root;
+    while (node != nullptr) {
+        if (antes(node->getItem())) {
+            node = node->getRight();
+        } else {
+            achado = node;
+            node = node->getLeft();
         }
-        delete[] tabela;
     }
-};
+    return achado;
+}
 
 template <typename T>
-auto HashTable<T>::buscarMostrarAltura(T key) {
-    int indice = Hash(key);
+template <typename K>
+int BST<T>::Rank(const K& chave) const {
+    return ContarAntes([&](const T& item) { return comparar(chave, item) > 0; });
+}
 
-    // ja ve se existe algo
-    if (tabela[indice] == nullptr) {
-        return -1;
+template <typename T>
+const T* BST<T>::Select(int i) const {
+    if (i < 0 || i >= numNos) {
+        return nullptr;
     }
+    BSTNode<T>* node = root;
+    while (true) {
+        int esquerda = getNodeTamanho(node->getLeft());
+        if (i < esquerda) {
+            node = node->getLeft();
+        } else if (i == esquerda) {
+            return &node->getItem();
+        } else {
+            i -= esquerda + 1;
+            node = node->getRight();
+        }
+    }
+}
 
-    // a arvore gerada com o codigo hash, agora procura a chave nela
-    BST<T>* arvore = tabela[indice];
-    BSTNode<T>* noAchado = arvore->Search(key);
+template <typename T>
+template <typename K1, typename K2>
+int BST<T>::CountRange(const K1& de, const K2& ate) const {
+    int ateFim = ContarAntes([&](const T& item) { return comparar(ate, item) >= 0; });
+    int antes = ContarAntes([&](const T& item) { return comparar(de, item) > 0; });
+    return ateFim > antes ? ateFim - antes : 0; // de > ate: faixa vazia
+}
 
-    // nao achou ouu achou?
+template <typename T>
+int BST<T>::CountPrefix(std::string_view prefixo) const {
+    // quem comeca com o prefixo fica junto na ordem: depois dos menores que ele e
+    // antes dos que os primeiros bytes ja passam dele
+    int ateFim = ContarAntes([&](const T& item) { return visaoChave(item).substr(0, prefixo.size()) <= prefixo; });
+    return ateFim - ContarAntes([&](const T& item) { return visaoChave(item) < prefixo; });
+}
+
+template <typename T>
+template <typename K1, typename K2, typename F>
+void BST<T>::EmFaixa(const K1& de, const K2& ate, F visitar) const {
+    BSTNode<T>* node = PrimeiroDepois([&](const T& item) { return comparar(de, item) > 0; });
+    for (; node != nullptr && comparar(ate, node->getItem()) >= 0; node = proximoEmOrdem(node)) {
+        visitar(node->getItem());
+    }
+}
+
+template <typename T>
+template <typename F>
+void BST<T>::EmPrefixo(std::string_view prefixo, F visitar) const {
+    BSTNode<T>* node = PrimeiroDepois([&](const T& item) { return visaoChave(item) < prefixo; });
+    for (; node != nullptr && visaoChave(node->getItem()).substr(0, prefixo.size()) == prefixo;
+         node = proximoEmOrdem(node)) {
+        visitar(node->getItem());
+    }
+}
+
+template <typename T>
+void BST<T>::Remove(const T &item) {
+    BSTNode<T>* node = Search(item);
+    if (node == nullptr) {
+        return;
+    }
+    // com dois filhos: copia o item do sucessor pra ca e quem sai e o sucessor
+    BSTNode<T>* alvo = node;
+    if (node->getLeft() != nullptr && node->getRight() != nullptr) {
+        alvo = maisEsquerda(node->getRight());
+        node->setItem(alvo->soltarItem()); // o sucessor vai ser liberado: move em vez de copiar
+    }
+    // alvo tem no maximo um filho: o filho sobe pro lugar dele
+    BSTNode<T>* filho = alvo->getLeft() != nullptr ? alvo->getLeft() : alvo->getRight();
+    BSTNode<T>* pai = alvo->getParent();
+#ifdef COM_ESTATISTICAS
+    // some o alvo e a subarvore do filho sobe um nivel
+    int64_t profundidadeAlvo = 0;
+    for (BSTNode<T>* p = alvo; p != nullptr; p = p->getParent()) profundidadeAlvo++;
+    contagem.somaProfundidades -= profundidadeAlvo + getNodeTamanho(filho);
+#endif
+    if (pai == nullptr) {
+        root = filho;
+        if (filho != nullptr) filho->setParent(nullptr);
+    } else if (pai->getLeft() == alvo) {
+        pai->setLeft(filho);
+    } else {
+        pai->setRight(filho);
+    }
+    liberarNo(alvo);
+    numNos--;
+
+    // depois de tudo, bota pra balancear
+    subirRebalanceando(pai, -1);
+/*por algum motivo isso aqui sempre retorna false mesmo quando funciona
+pq???
+mas no fim das contas o remove nem vai ser usado no final entao n deve ser prioridade consertar isso
+mas sla seria meio estranho enviar o trabalho terminado com isso funcionando errado
+o importante e o q importa
+
+EDIT: por via das duvidas, transformei em void, meio que nem é necessario devolver nada
+*/
+
+}
+
+template <typename T>
+template <typename K>
+BSTNode<T>* BST<T>::InsertRecursivoHelper(BSTNode<T>* node, const K& item, int64_t profundidade) {
+    if (node == nullptr) {
+        numNos++;
+        SO_ESTATISTICA(contagem.somaProfundidades += profundidade;)
+        return novoNo(item);
+    }
+    int cmp = comparar(item, node->getItem());
+    if (cmp < 0) node->setLeft(InsertRecursivoHelper(node->getLeft(), item, profundidade + 1));
+    else if (cmp > 0) node->setRight(InsertRecursivoHelper(node->getRight(), item, profundidade + 1));
+    else return node;
+
+    // depois de tudo, bota pra balancear
+    return rebalance(node);
+}
+
+template <typename T>
+BSTNode<T>* BST<T>::RemoveRecursivoHelper(BSTNode<T>* node, const T& item, int64_t profundidade) {
+    if (node == nullptr) return nullptr;
+    int cmp = comparar(item, node->getItem());
+    if (cmp < 0) node->setLeft(RemoveRecursivoHelper(node->getLeft(), item, profundidade + 1));
+    else if (cmp > 0) node->setRight(RemoveRecursivoHelper(node->getRight(), item, profundidade + 1));
+    else {
+        // sem um dos filhos: o outro sobe pro lugar dele
+        if (node->getLeft() == nullptr || node->getRight() == nullptr) {
+            BSTNode<T>* filho = node->getLeft() != nullptr ? node->getLeft() : node->getRight();
+            SO_ESTATISTICA(contagem.somaProfundidades -= profundidade + getNodeTamanho(filho);)
+            liberarNo(node);
+            numNos--;
+            return filho;
+        }
+        // com dois filhos: copia o item do sucessor e remove ele da subarvore direita
+        // (usa a copia que ficou aqui: o item do sucessor morre la embaixo)
+        node->setItem(maisEsquerda(node->getRight())->getItem());
+        node->setRight(RemoveRecursivoHelper(node->getRight(), node->getItem(), profundidade + 1));
+    }
+
+    // depois de tudo, bota pra balancear
+    return rebalance(node);
+}
+
+template <typename T>
+template <typename K>
+BSTNode<T>* BST<T>::SearchRecursivoHelper(const K& item, BSTNode<T>* node) {
+    if (node == nullptr) return nullptr;
+    SO_ESTATISTICA(contagem.sondagens++;)
+    int cmp = comparar(item, node->getItem());
+    if (cmp < 0) return SearchRecursivoHelper(item, node->getLeft());
+    else if (cmp > 0) return SearchRecursivoHelper(item, node->getRight());
+    else return node;
+}
+
+// DESENHADOR DE AUTOMATO
+template <typename T>
+void BST<T>::generateDot(BSTNode<T>* node, std::ostream& out) {
+    // pre-ordem sem recursao; os filhos so sao visitados se tem filho direito
+    // (igual sempre foi: a saida do testador depende disso)
+    BSTNode<T>* topo = node;
+    while (node != nullptr) {
+        // Adiciona o nó atual com a altura
+        out << "    " << node->getItem() << " [label=\"" << node->getItem() << "\\nAltura: " << node->getHeight() << "\"];\n";
+        // Conecta o nó atual aos filhos
+        if (node->getLeft() != nullptr) {
+            out << "    " << node->getItem() << " -> " << node->getLeft()->getItem() << ";\n";
+        }
+        if (node->getRight()) {
+            out << "    " << node->getItem() << " -> " << node->getRight()->getItem() << ";\n";
+            // desce: primeiro a esquerda, depois a direita
+            node = node->getLeft() != nullptr ? node->getLeft() : node->getRight();
+            continue;
+        }
+        // sobe ate um pai visitado pela esquerda (esse sempre tem direita)
+        while (true) {
+            BSTNode<T>* pai = node->getParent();
+            if (node == topo || pai == nullptr) {
+                node = nullptr;
+                break;
+            }
+            if (pai->getLeft() == node) {
+                node = pai->getRight();
+                break;
+            }
+            node = pai;
+        }
+    }
+}
+
+template <typename T>
+void BST<T>::drawTree(BSTNode<T>* root) {
+    std::cout << "digraph G {\n";
+    generateDot(root, std::cout);
+    std::cout << "}\n";
+}
+
+// POLITICAS DE HASH
+// Cada politica recebe a chave e o numero de gavetas e devolve o indice ja reduzido.
+// So usa inteiro: nada de pow() por caractere.
+
+// 8 primeiros bytes da chave como inteiro big-endian (o que falta fica zerado):
+// comparar dois prefixos da a mesma ordem da string (byte sem sinal)
+inline uint64_t prefixo64(std::string_view chave) {
+    uint64_t p = 0;
+    if (chave.size() >= 8) {
+        // caso comum na busca: uma leitura de 8 bytes so (memcpy de tamanho fixo)
+        memcpy(&p, chave.data(), 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        p = __builtin_bswap64(p);
+#endif
+        return p;
+    }
+    for (size_t i = 0; i < chave.size(); i++) {
+        p |= static_cast<uint64_t>(static_cast<unsigned char>(chave[i])) << (56 - 8 * i);
+    }
+    return p;
+}
+
+// CHAVES INTERNADAS
+// std::string no no gasta 32 bytes (e mais um malloc se passar de 15 caracteres).
+// Aqui o texto das palavras fica todo no PoolPalavras, uma atras da outra, e o no
+// guarda so uma ChaveInterna de 12 bytes: os 4 primeiros bytes, deslocamento de 32 bits
+// no pool e tamanho. O no fica com 48 bytes em vez de 64 (eram 40 antes do tamanho da
+// subarvore entrar no no), entao no --internado a economia por chave no texto_base caiu
+// de uns 22% pra uns 14,6%. Quase toda comparacao decide so pelo prefixo, sem ir no pool.
+// O pool e um so pro programa (o comparar nao tem como saber de qual tabela e a chave)
+// e so cresce: a tabela so cria chave pra palavra nova, e remover nao devolve os bytes.
+// Os blocos nunca mudam de lugar, entao view de chave continua valendo. Nao e thread-safe.
+class PoolPalavras {
+public:
+    static const int BITS_BLOCO = 20;
+    static const size_t BLOCO = static_cast<size_t>(1) << BITS_BLOCO; // palavra nao atravessa bloco
+
+    static PoolPalavras& global() {
+        static PoolPalavras pool;
+        return pool;
+    }
+
+    // copia a palavra pro fim do pool e devolve onde ficou
+    uint32_t guardar(std::string_view palavra) {
+        if (palavra.empty()) {
+            return 0;
+        }
+        if (palavra.size() > BLOCO) {
+            throw std::length_error("palavra maior que um bloco do pool");
+        }
+        if (blocos.empty() || livre + palavra.size() > BLOCO) {
+            if (blocos.size() >= (static_cast<size_t>(1) << (32 - BITS_BLOCO))) {
+                throw std::length_error("pool de palavras passou de 4 GiB");
+            }
+            blocos.push_back(new char[BLOCO]);
+            livre = 0;
+        }
+        memcpy(blocos.back() + livre, palavra.data(), palavra.size());
+        uint32_t deslocamento = static_cast<uint32_t>(((blocos.size() - 1) << BITS_BLOCO) | livre);
+        livre += palavra.size();
+        usados += palavra.size();
+        return deslocamento;
+    }
+    std::string_view ver(uint32_t deslocamento, uint32_t tamanho) const {
+        if (tamanho == 0) {
+            return std::string_view();
+        }
+        return std::string_view(blocos[deslocamento >> BITS_BLOCO] + (deslocamento & (BLOCO - 1)), tamanho);
+    }
+
+    size_t bytesUsados() const { return usados; }
+    size_t bytesReservados() const { return blocos.size() * BLOCO; }
+
+    ~PoolPalavras() {
+        for (char* bloco : blocos) delete[] bloco;
+    }
+
+private:
+    PoolPalavras() = default;
+    vector<char*> blocos;
+    size_t livre = 0; // proxima posicao livre no ultimo bloco
+    size_t usados = 0;
+};
+
+struct ChaveInterna {
+    uint32_t prefixo;
+    uint32_t deslocamento;
+    uint32_t tamanho;
+
+    ChaveInterna() : prefixo(0), deslocamento(0), tamanho(0) {}
+    // criar a chave ja guarda a palavra no pool (copiar a chave depois nao guarda de novo)
+    explicit ChaveInterna(std::string_view palavra)
+        : prefixo(static_cast<uint32_t>(prefixo64(palavra) >> 32)),
+          deslocamento(PoolPalavras::global().guardar(palavra)),
+          tamanho(static_cast<uint32_t>(palavra.size())) {}
+    explicit ChaveInterna(const std::string& palavra) : ChaveInterna(std::string_view(palavra)) {}
+
+    std::string_view ver() const { return PoolPalavras::global().ver(deslocamento, tamanho); }
+};
+
+inline std::string_view visaoChave(const ChaveInterna& item) { return item.ver(); }
+
+inline std::ostream& operator<<(std::ostream& out, const ChaveInterna& item) {
+    return out << item.ver();
+}
+
+// prefixos iguais e uma das duas cabe em 4 bytes: a mais curta e prefixo da outra,
+// entao o tamanho decide. So as duas compridas precisam ir no pool.
+inline int comparar(const ChaveInterna& a, const ChaveInterna& b) {
+    if (a.prefixo != b.prefixo) return a.prefixo < b.prefixo ? -1 : 1;
+    if (a.tamanho <= 4 || b.tamanho <= 4) return comparar(a.tamanho, b.tamanho);
+    return a.ver().compare(b.ver());
+}
+
+inline int comparar(std::string_view a, const ChaveInterna& b) {
+    uint32_t prefixo = static_cast<uint32_t>(prefixo64(a) >> 32);
+    if (prefixo != b.prefixo) return prefixo < b.prefixo ? -1 : 1;
+    if (a.size() <= 4 || b.tamanho <= 4) return comparar(a.size(), static_cast<size_t>(b.tamanho));
+    return a.compare(b.ver());
+}
+
+// Mesma distribuicao da funcao antiga (soma de c * 128^(n-i-1) com modulo a cada passo).
+// O pow(128, k) era exato (potencia de 2), entao vira shift. Pra k >= 10 o cast do double
+// pra size_t estourava e dava 0 no x86-64, entao so os 10 ultimos caracteres contam.
+// O char e com sinal igual antes (acento vira numero gigante e da a volta no size_t).
+struct HashLegado {
+    static constexpr const char* nome = "legado";
+    size_t operator()(std::string_view chave, size_t tamanho) const {
+        size_t hashValue = 0;
+        size_t n = chave.length();
+        for (size_t i = 0; i < n; ++i) {
+            size_t k = n - i - 1;
+            size_t potencia = k < 10 ? static_cast<size_t>(1) << (7 * k) : 0;
+            hashValue += static_cast<size_t>(chave[i]) * potencia;
+            hashValue %= tamanho;
+        }
+        return hashValue;
+    }
+};
+
+// Horner inteiro: h = h * B + c, um modulo so no final
+struct HashHorner {
+    static constexpr const char* nome = "horner";
+    size_t operator()(std::string_view chave, size_t tamanho) const {
+        uint64_t h = 0;
+        for (unsigned char c : chave) {
+            h = h * 131 + c;
+        }
+        return h % tamanho;
+    }
+};
+
+struct HashFNV1a {
+    static constexpr const char* nome = "fnv1a";
+    size_t operator()(std::string_view chave, size_t tamanho) const {
+        uint64_t h = 14695981039346656037ULL;
+        for (unsigned char c : chave) {
+            h ^= c;
+            h *= 1099511628211ULL;
+        }
+        return h % tamanho;
+    }
+};
+
+// le 8 bytes de uma vez (memcpy pra nao depender de alinhamento)
+inline uint64_t lerPalavra64(const char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// le de 1 a 8 bytes sem passar do fim da chave
+inline uint64_t lerResto64(const char* p, size_t n) {
+    uint64_t v = 0;
+    std::memcpy(&v, p, n);
+    return v;
+}
+
+// multiplica 64x64 -> 128 e junta as duas metades (mistura do wyhash)
+inline uint64_t misturar64(uint64_t a, uint64_t b) {
+    unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+    return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+}
+
+// Estilo wyhash/xxHash: consome 8 bytes por vez e mistura com multiplicacao de 128 bits
+struct HashMistura64 {
+    static constexpr const char* nome = "mistura64";
+    size_t operator()(std::string_view chave, size_t tamanho) const {
+        const uint64_t s0 = 0xa0761d6478bd642fULL;
+        const uint64_t s1 = 0xe7037ed1a0b428dbULL;
+        const char* p = chave.data();
+        size_t n = chave.size();
+        uint64_t h = s0 ^ n;
+        while (n > 8) {
+            h = misturar64(h ^ lerPalavra64(p), s1);
+            p += 8;
+            n -= 8;
+        }
+        if (n > 0) {
+            h = misturar64(h ^ lerResto64(p, n), s1);
+        }
+        return misturar64(h, s0 ^ s1) % tamanho;
+    }
+};
+
+// Versao amiga de SIMD: 4 acumuladores independentes sobre blocos de 32 bytes,
+// sem dependencia entre as faixas, o compilador consegue vetorizar o laco principal.
+struct HashBlocos {
+    static constexpr const char* nome = "blocos";
+    size_t operator()(std::string_view chave, size_t tamanho) const {
+        const uint64_t primo = 0x9e3779b97f4a7c15ULL;
+        uint64_t faixa[4] = {primo, primo ^ 1, primo ^ 2, primo ^ 3};
+        const char* p = chave.data();
+        size_t n = chave.size();
+        while (n >= 32) {
+            for (int j = 0; j < 4; j++) {
+                faixa[j] = (faixa[j] ^ lerPalavra64(p + 8 * j)) * primo;
+            }
+            p += 32;
+            n -= 32;
+        }
+        uint64_t h = faixa[0] ^ (faixa[1] >> 1) ^ (faixa[2] >> 2) ^ (faixa[3] >> 3) ^ chave.size();
+        while (n >= 8) {
+            h = misturar64(h ^ lerPalavra64(p), primo);
+            p += 8;
+            n -= 8;
+        }
+        if (n > 0) {
+            h = misturar64(h ^ lerResto64(p, n), primo);
+        }
+        return misturar64(h, primo) % tamanho;
+    }
+};
+
+// MODO MAPA: a arvore guarda pares chave -> valor. So a chave entra na ordem (e no
+// hash), entao BST<EntradaMapa<K, V>> ja e um mapa ordenado. O valor e mutable: da pra
+// mexer nele pelo const T& que a arvore entrega sem poder mexer na chave.
+// Com chave nova o valor comeca em V() (contagem comeca em 0).
+template <typename K, typename V>
+struct EntradaMapa {
+    K chave;
+    mutable V valor;
+
+    EntradaMapa() : chave(), valor() {}
+    // qualquer coisa que monte a chave (string_view, string...), menos outra entrada
+    template <typename C, typename = typename std::enable_if<
+                              !std::is_same<typename std::decay<C>::type, EntradaMapa>::value>::type>
+    explicit EntradaMapa(C&& chave) : chave(std::forward<C>(chave)), valor() {}
+    EntradaMapa(K chave, V valor) : chave(std::move(chave)), valor(std::move(valor)) {}
+};
+
+template <typename K, typename V>
+inline std::string_view visaoChave(const EntradaMapa<K, V>& e) {
+    return visaoChave(e.chave);
+}
+template <typename K, typename V>
+inline int comparar(const EntradaMapa<K, V>& a, const EntradaMapa<K, V>& b) {
+    return comparar(a.chave, b.chave);
+}
+template <typename K, typename V>
+inline int comparar(std::string_view a, const EntradaMapa<K, V>& b) {
+    return comparar(a, b.chave);
+}
+template <typename T>
+struct ehEntradaMapa : std::false_type {};
+template <typename K, typename V>
+struct ehEntradaMapa<EntradaMapa<K, V>> : std::true_type {};
+// no desenho da arvore sai "chave:valor"
+template <typename K, typename V>
+inline std::ostream& operator<<(std::ostream& out, const EntradaMapa<K, V>& e) {
+    return out << e.chave << ':' << e.valor;
+}
+
+// BALDE PLANO (EYTZINGER)
+// Alternativa a arvore de nos pra usar como gaveta: os itens ficam num vetor ordenado
+// e a busca desce num segundo vetor na ordem de Eytzinger (raiz em 1, filhos de k em
+// 2k e 2k+1), sem ponteiro nenhum. Cada entrada tem 16 bytes: os 8 primeiros bytes da
+// chave em big-endian (da pra comparar como inteiro), o tamanho e o indice do item.
+// Chave de ate 8 bytes se resolve so com a entrada; mais longa so vai na string quando
+// os 8 bytes empatam. Sao 4 entradas por linha de cache e os netos de k (4k..4k+3)
+// ficam juntos, entao da pra pedir eles dois niveis antes.
+// Insert/Remove mexem so no vetor ordenado e marcam sujo; o layout e refeito na proxima
+// busca (bom pra carregar e depois consultar muito, ruim pra ficar alternando).
+// Serve pra T com visaoChave (string).
+struct ArenaVazia { // o balde plano usa vector proprio, nao tira nada de arena
+    void clear() {}
+    size_t bytesReservados() const { return 0; }
+    size_t bytesVivos() const { return 0; }
+};
+
+template <typename T>
+class BaldeEytzinger {
+private:
+    struct Entrada {
+        uint64_t prefixo;
+        uint32_t tamanho;
+        uint32_t indice; // posicao em itens
+    };
+    vector<T> itens;      // ordenado e sem repetidas
+    vector<Entrada> eytz; // eytz[1..n], a posicao 0 nao e usada
+    bool sujo = false;
+
+    // entrada < chave? (mesma ordem da string: byte sem sinal)
+    bool menor(const Entrada& e, uint64_t prefixo, std::string_view chave) const {
+        if (e.prefixo != prefixo) return e.prefixo < prefixo;
+        // 8 bytes iguais e uma delas cabe neles: a mais curta e prefixo da outra
+        if (e.tamanho <= 8 || chave.size() <= 8) return e.tamanho < chave.size();
+        return visaoChave(itens[e.indice]).compare(chave) < 0;
+    }
+
+    template <typename K>
+    typename vector<T>::iterator posicao(const K& item) {
+        return lower_bound(itens.begin(), itens.end(), visaoChave(item),
+                           [](const T& a, std::string_view b) { return visaoChave(a) < b; });
+    }
+    // primeiro >= chave, primeiro > chave e primeiro depois de quem comeca com prefixo
+    typename vector<T>::const_iterator inicioDe(std::string_view chave) const {
+        return partition_point(itens.begin(), itens.end(), [&](const T& a) { return visaoChave(a) < chave; });
+    }
+    typename vector<T>::const_iterator fimDe(std::string_view chave) const {
+        return partition_point(itens.begin(), itens.end(), [&](const T& a) { return visaoChave(a) <= chave; });
+    }
+    typename vector<T>::const_iterator fimPrefixo(std::string_view prefixo) const {
+        return partition_point(itens.begin(), itens.end(), [&](const T& a) {
+            return visaoChave(a).substr(0, prefixo.size()) <= prefixo;
+        });
+    }
+
+    void montarHelper(size_t k, size_t& i) {
+        if (k >= eytz.size()) return;
+        montarHelper(2 * k, i);
+        std::string_view v = visaoChave(itens[i]);
+        eytz[k] = {prefixo64(v), static_cast<uint32_t>(v.size()), static_cast<uint32_t>(i)};
+        i++;
+        montarHelper(2 * k + 1, i);
+    }
+    void montar() {
+        eytz.resize(itens.size() + 1);
+        size_t i = 0;
+        montarHelper(1, i);
+        sujo = false;
+    }
+    bool conferirHelper(size_t k, size_t& i) const {
+        if (k > itens.size()) return true;
+        if (!conferirHelper(2 * k, i)) return false;
+        std::string_view v = visaoChave(itens[i]);
+        if (eytz[k].indice != i || eytz[k].tamanho != v.size() || eytz[k].prefixo != prefixo64(v)) return false;
+        i++;
+        return conferirHelper(2 * k + 1, i);
+    }
+
+public:
+    typedef ArenaVazia Arena;
+
+    explicit BaldeEytzinger(ArenaVazia* = nullptr) {}
+    void setArena(ArenaVazia*) {}
+
+    // devolve o item (ou nullptr), igual o Search da BST devolve o no
+    template <typename K>
+    const T* Search(const K& item) {
+        if (sujo) montar();
+        std::string_view chave = visaoChave(item);
+        uint64_t prefixo = prefixo64(chave);
+        const Entrada* e = eytz.data();
+        size_t n = itens.size();
+        size_t k = 1;
+        while (k <= n) {
+            if (4 * k <= n) __builtin_prefetch(e + 4 * k);
+            k = 2 * k + menor(e[k], prefixo, chave); // sem if: so vira a conta
+        }
+        // desfaz as viradas pra direita do fim: sobra o lower_bound (0 = passou de todos)
+        k >>= __builtin_ffsll(static_cast<long long>(~k));
+        if (k == 0 || e[k].prefixo != prefixo || e[k].tamanho != chave.size()) {
+            return nullptr;
+        }
+        const T& achado = itens[e[k].indice];
+        if (chave.size() > 8 && visaoChave(achado) != chave) {
+            return nullptr;
+        }
+        return &achado;
+    }
+
+    template <typename K>
+    void Insert(K&& item) {
+        InsertOuAcha(std::forward<K>(item));
+    }
+    // a referencia vale ate o proximo Insert/Remove (o vetor anda)
+    template <typename K>
+    const T& InsertOuAcha(K&& item) {
+        auto pos = posicao(item);
+        if (pos != itens.end() && visaoChave(*pos) == visaoChave(item)) {
+            return *pos;
+        }
+        sujo = true;
+        return *itens.emplace(pos, std::forward<K>(item));
+    }
+    void Remove(const T& item) {
+        auto pos = posicao(item);
+        if (pos != itens.end() && visaoChave(*pos) == visaoChave(item)) {
+            itens.erase(pos);
+            sujo = true;
+        }
+    }
+    int size() const { return static_cast<int>(itens.size()); }
+
+    // rehash: entrega um ponteiro pra cada item e o destino move a string pra ele
+    template <typename F>
+    void Esvaziar(F destino) {
+        for (T& item : itens) {
+            destino(&item);
+        }
+        itens.clear();
+        eytz.clear();
+        sujo = false;
+    }
+    void InsertNode(T* item) {
+        auto pos = posicao(*item);
+        itens.emplace(pos, std::move(*item));
+        sujo = true;
+    }
+    static const T& itemDo(const T* item) { return *item; }
+    void Abandonar() {} // sem arena: o delete ja solta os vetores
+
+    template <typename It>
+    void CarregarOrdenado(It inicio, It fim) {
+        itens.clear();
+        for (; inicio != fim; ++inicio) {
+            itens.emplace_back(*inicio);
+        }
+        montar();
+    }
+    template <typename F>
+    void EmOrdem(F visitar) const {
+        for (const T& item : itens) visitar(item);
+    }
+
+    // em ordem igual o da BST (aqui e so o iterador do vetor)
+    typedef typename vector<T>::const_iterator const_iterator;
+    const_iterator begin() const { return itens.begin(); }
+    const_iterator end() const { return itens.end(); }
+
+    // mesmas consultas de ordem da BST, aqui direto no vetor ordenado
+    template <typename K>
+    int Rank(const K& chave) const {
+        return static_cast<int>(inicioDe(visaoChave(chave)) - itens.begin());
+    }
+    const T* Select(int i) const {
+        return i >= 0 && i < size() ? &itens[i] : nullptr;
+    }
+    template <typename K1, typename K2>
+    int CountRange(const K1& de, const K2& ate) const {
+        auto fim = fimDe(visaoChave(ate));
+        auto inicio = inicioDe(visaoChave(de));
+        return fim > inicio ? static_cast<int>(fim - inicio) : 0;
+    }
+    int CountPrefix(std::string_view prefixo) const {
+        return static_cast<int>(fimPrefixo(prefixo) - inicioDe(prefixo));
+    }
+    template <typename K1, typename K2, typename F>
+    void EmFaixa(const K1& de, const K2& ate, F visitar) const {
+        for (auto it = inicioDe(visaoChave(de)), fim = fimDe(visaoChave(ate)); it < fim; ++it) visitar(*it);
+    }
+    template <typename F>
+    void EmPrefixo(std::string_view prefixo, F visitar) const {
+        for (auto it = inicioDe(prefixo), fim = fimPrefixo(prefixo); it < fim; ++it) visitar(*it);
+    }
+
+    // mesmo nome do BST pra HashTable::conferirArvores: ordem dos itens + layout
+    bool ConferirAVL() const {
+        for (size_t i = 1; i < itens.size(); i++) {
+            if (!(visaoChave(itens[i - 1]) < visaoChave(itens[i]))) return false;
+        }
+        if (sujo) return true;
+        size_t i = 0;
+        return eytz.size() == itens.size() + 1 && conferirHelper(1, i) && i == itens.size();
+    }
+
+    // niveis da arvore implicita = comparacoes de uma descida (floor(log2 n) + 1)
+    int altura() const { return itens.empty() ? 0 : 64 - __builtin_clzll(itens.size()); }
+
+    // mesmo formato do drawTree, com a profundidade de cada posicao
+    void desenhar() {
+        if (sujo) montar();
+        std::cout << "digraph G {\n";
+        for (size_t k = 1; k < eytz.size(); k++) {
+            const T& item = itens[eytz[k].indice];
+            std::cout << "    " << item << " [label=\"" << item << "\\nProfundidade: " << 64 - __builtin_clzll(k) << "\"];\n";
+            for (size_t filho = 2 * k; filho <= 2 * k + 1 && filho < eytz.size(); filho++) {
+                std::cout << "    " << item << " -> " << itens[eytz[filho].indice] << ";\n";
+            }
+        }
+        std::cout << "}\n";
+    }
+};
+
+// MESCLA DAS GAVETAS: cada gaveta ja e ordenada, entao a lista global sai de um heap
+// com o item atual de cada uma (k-way merge): o menor sai, a gaveta dele anda um e
+// desce no heap. O heap e montado uma vez no comeco (uma entrada por gaveta com
+// item); depois disso andar nao aloca nada. Cada entrada guarda os 8 primeiros bytes
+// da chave (prefixo64): quase toda comparacao do heap se resolve sem ir no no.
+// E um range de entrada: for (const T& item : tabela.ordenada()) { ... }
+// Vale enquanto a tabela nao mudar.
+template <typename T, typename Balde>
+class MesclaGavetas {
+private:
+    typedef typename Balde::const_iterator Cursor;
+    struct Fonte {
+        uint64_t prefixo;
+        std::string_view chave;
+        Cursor atual;
+        Cursor fim;
+    };
+    vector<Fonte> heap; // a menor chave fica em heap[0]
+
+    static bool menor(const Fonte& a, const Fonte& b) {
+        if (a.prefixo != b.prefixo) return a.prefixo < b.prefixo;
+        return a.chave < b.chave;
+    }
+    static void ler(Fonte& f) {
+        f.chave = visaoChave(*f.atual);
+        f.prefixo = prefixo64(f.chave);
+    }
+    // a raiz mudou (ou saiu): desce ate o lugar dela, uma comparacao por nivel pra
+    // achar o menor filho (pop_heap + push_heap fariam duas passadas)
+    void descer() {
+        size_t n = heap.size();
+        Fonte f = heap[0];
+        size_t i = 0;
+        while (true) {
+            size_t filho = 2 * i + 1;
+            if (filho >= n) break;
+            if (filho + 1 < n && menor(heap[filho + 1], heap[filho])) filho++;
+            if (!menor(heap[filho], f)) break;
+            heap[i] = heap[filho];
+            i = filho;
+        }
+        heap[i] = f;
+    }
+
+public:
+    explicit MesclaGavetas(size_t gavetas) { heap.reserve(gavetas); }
+    void adicionar(const Balde& balde) {
+        if (balde.begin() == balde.end()) return;
+        heap.push_back({0, {}, balde.begin(), balde.end()});
+        ler(heap.back());
+    }
+    void preparar() {
+        make_heap(heap.begin(), heap.end(), [](const Fonte& a, const Fonte& b) { return menor(b, a); });
+    }
+    bool vazia() const { return heap.empty(); }
+    const T& atual() const { return *heap[0].atual; }
+    void avancar() {
+        Fonte& topo = heap[0];
+        if (++topo.atual == topo.fim) {
+            topo = heap.back(); // gaveta acabou: a ultima do heap vai pra raiz
+            heap.pop_back();
+            if (heap.empty()) return;
+        } else {
+            ler(topo);
+        }
+        descer();
+    }
+
+    class iterator {
+    private:
+        MesclaGavetas* mescla; // nullptr = fim
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T* pointer;
+        typedef const T& reference;
+
+        explicit iterator(MesclaGavetas* mescla = nullptr) : mescla(mescla) {}
+        const T& operator*() const { return mescla->atual(); }
+        const T* operator->() const { return &mescla->atual(); }
+        iterator& operator++() {
+            mescla->avancar();
+            return *this;
+        }
+        // so compara com o fim (iterador de entrada)
+        bool operator==(const iterator& outro) const { return acabou() == outro.acabou(); }
+        bool operator!=(const iterator& outro) const { return acabou() != outro.acabou(); }
+    private:
+        bool acabou() const { return mescla == nullptr || mescla->vazia(); }
+    };
+    iterator begin() { return iterator(this); }
+    iterator end() { return iterator(); }
+};
+
+#ifdef COM_ESTATISTICAS
+// HISTOGRAMA DE LATENCIA no estilo do HDR: ate 16 ns cada valor tem a sua faixa; dali
+// pra cima cada potencia de 2 e dividida em 16 faixas iguais, entao o erro fica abaixo
+// de 6.25% em qualquer escala com um numero fixo de contadores (976). Contadores
+// atomicos: outra thread pode ler enquanto a dona grava.
+class HistogramaLatencia {
+public:
+    static const int SUB = 16;
+    static const int FAIXAS = (64 - 3) * SUB;
+
+private:
+    std::atomic<uint64_t> contagem[FAIXAS];
+    std::atomic<uint64_t> soma{0};
+    std::atomic<uint64_t> maior{0};
+
+public:
+    HistogramaLatencia() {
+        for (auto& c : contagem) c.store(0, std::memory_order_relaxed);
+    }
+
+    static int faixa(uint64_t ns) {
+        if (ns < static_cast<uint64_t>(SUB)) return static_cast<int>(ns);
+        int e = 63 - __builtin_clzll(ns); // e >= 4
+        return (e - 3) * SUB + static_cast<int>((ns >> (e - 4)) & (SUB - 1));
+    }
+    static uint64_t inicioFaixa(int f) {
+        if (f < SUB) return static_cast<uint64_t>(f);
+        int e = f / SUB + 3;
+        return static_cast<uint64_t>(SUB + f % SUB) << (e - 4);
+    }
+    static uint64_t fimFaixa(int f) { return f + 1 < FAIXAS ? inicioFaixa(f + 1) - 1 : UINT64_MAX; }
+
+    void registrar(uint64_t ns) {
+        contagem[faixa(ns)].fetch_add(1, std::memory_order_relaxed);
+        soma.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t atual = maior.load(std::memory_order_relaxed);
+        while (ns > atual && !maior.compare_exchange_weak(atual, ns, std::memory_order_relaxed)) {
+        }
+    }
+    // n operacoes medidas juntas (lote): cada uma entra com a media, ns / n
+    void registrarLote(uint64_t ns, uint64_t n) {
+        if (n == 0) return;
+        uint64_t cada = ns / n;
+        contagem[faixa(cada)].fetch_add(n, std::memory_order_relaxed);
+        soma.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t atual = maior.load(std::memory_order_relaxed);
+        while (cada > atual && !maior.compare_exchange_weak(atual, cada, std::memory_order_relaxed)) {
+        }
+    }
+
+    // copia dos contadores (o resto das contas e em cima dela, pra bater entre si)
+    vector<uint64_t> copiar(uint64_t& total) const {
+        vector<uint64_t> c(FAIXAS);
+        total = 0;
+        for (int f = 0; f < FAIXAS; f++) {
+            c[f] = contagem[f].load(std::memory_order_relaxed);
+            total += c[f];
+        }
+        return c;
+    }
+    // fim da faixa onde a acumulada passa de p (0 se vazio)
+    static uint64_t percentil(const vector<uint64_t>& c, uint64_t total, double p) {
+        if (total == 0) return 0;
+        uint64_t alvo = static_cast<uint64_t>(std::ceil(p * total));
+        uint64_t acumulado = 0;
+        for (int f = 0; f < FAIXAS; f++) {
+            acumulado += c[f];
+            if (acumulado >= max<uint64_t>(alvo, 1)) return fimFaixa(f);
+        }
+        return fimFaixa(FAIXAS - 1);
+    }
+    uint64_t somaNs() const { return soma.load(std::memory_order_relaxed); }
+    uint64_t maximo() const { return maior.load(std::memory_order_relaxed); }
+};
+
+// tudo que a HashTable conta com -DCOM_ESTATISTICAS. So a thread dona da tabela grava
+// (as mesmas regras da tabela); json/prometheus so leem atomicos, entao da pra exportar
+// de outra thread no meio do trabalho sem parar nada. As gavetas ficam num vetor que e
+// trocado inteiro quando a tabela cresce (shared_ptr atomico: quem esta lendo o velho
+// continua com ele).
+class EstatisticasTabela {
+public:
+    struct Gaveta {
+        std::atomic<int64_t> itens{0};
+        std::atomic<int64_t> altura{0};
+        std::atomic<int64_t> somaProfundidades{0};
+    };
+    struct Gavetas {
+        size_t n;
+        std::unique_ptr<Gaveta[]> g;
+        explicit Gavetas(size_t n) : n(n), g(new Gaveta[n]) {}
+    };
+
+    std::atomic<uint64_t> itens{0};
+    std::atomic<uint64_t> inserts{0}, insertsNovos{0};
+    std::atomic<uint64_t> buscas{0}, buscasAchadas{0}, sondagens{0};
+    std::atomic<uint64_t> removes{0}, removesAchados{0};
+    std::atomic<uint64_t> rotacoesInsert{0}, rotacoesRemove{0};
+    HistogramaLatencia latInsert, latBusca, latRemove;
+
+private:
+    std::shared_ptr<Gavetas> gavetas;
+
+    static void somar(std::atomic<uint64_t>& c, uint64_t n) { c.fetch_add(n, std::memory_order_relaxed); }
+
+    struct Resumo {
+        uint64_t total;
+        vector<uint64_t> c;
+        explicit Resumo(const HistogramaLatencia& h) { c = h.copiar(total); }
+        uint64_t p(double q) const { return HistogramaLatencia::percentil(c, total, q); }
+    };
+
+public:
+    explicit EstatisticasTabela(size_t n) { novasGavetas(n); }
+
+    void novasGavetas(size_t n) { std::atomic_store(&gavetas, std::make_shared<Gavetas>(n)); }
+    std::shared_ptr<Gavetas> lerGavetas() const { return std::atomic_load(&gavetas); }
+    void gaveta(size_t i, int64_t itensGaveta, int64_t altura, int64_t somaProfundidades) {
+        Gavetas& gs = *gavetas; // so a dona troca o vetor, ela le sem atomic_load
+        if (i >= gs.n) return;
+        gs.g[i].itens.store(itensGaveta, std::memory_order_relaxed);
+        gs.g[i].altura.store(altura, std::memory_order_relaxed);
+        gs.g[i].somaProfundidades.store(somaProfundidades, std::memory_order_relaxed);
+    }
+
+    static uint64_t desde(chrono::steady_clock::time_point inicio) {
+        return static_cast<uint64_t>(
+            chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - inicio).count());
+    }
+    void registrarInsert(const ContadoresArvore& antes, const ContadoresArvore& depois, bool novo) {
+        somar(inserts, 1);
+        somar(insertsNovos, novo);
+        somar(rotacoesInsert, depois.rotacoes - antes.rotacoes);
+    }
+    void registrarBusca(const ContadoresArvore& antes, const ContadoresArvore& depois, bool achou) {
+        somar(buscas, 1);
+        somar(buscasAchadas, achou);
+        somar(sondagens, depois.sondagens - antes.sondagens);
+    }
+    // searchMany desce as arvores na mao: conta o lote inteiro de uma vez
+    void registrarBuscas(uint64_t n, uint64_t achadas, uint64_t sondagensLote) {
+        somar(buscas, n);
+        somar(buscasAchadas, achadas);
+        somar(sondagens, sondagensLote);
+    }
+    void registrarRemove(const ContadoresArvore& antes, const ContadoresArvore& depois, bool achou) {
+        somar(removes, 1);
+        somar(removesAchados, achou);
+        somar(rotacoesRemove, depois.rotacoes - antes.rotacoes);
+    }
+
+    void json(ostream& out) const;
+    void prometheus(ostream& out, const string& prefixo = "pp3") const;
+};
+
+inline void EstatisticasTabela::json(ostream& out) const {
+    auto ler = [](const std::atomic<uint64_t>& c) { return c.load(std::memory_order_relaxed); };
+    auto razao = [](double a, double b) { return b > 0 ? a / b : 0.0; };
+    std::shared_ptr<Gavetas> gs = lerGavetas();
+    int64_t itensGavetas = 0, soma = 0, alturaMax = 0;
+    for (size_t i = 0; i < gs->n; i++) {
+        itensGavetas += gs->g[i].itens.load(std::memory_order_relaxed);
+        soma += gs->g[i].somaProfundidades.load(std::memory_order_relaxed);
+        alturaMax = max<int64_t>(alturaMax, gs->g[i].altura.load(std::memory_order_relaxed));
+    }
+    out << "{\n  \"itens\": " << ler(itens) << ",\n  \"gavetas\": " << gs->n
+        << ",\n  \"operacoes\": {\"insert\": " << ler(inserts) << ", \"insert_novos\": " << ler(insertsNovos)
+        << ", \"busca\": " << ler(buscas) << ", \"busca_achou\": " << ler(buscasAchadas)
+        << ", \"remove\": " << ler(removes) << ", \"remove_achou\": " << ler(removesAchados) << "}"
+        << ",\n  \"sondagens_por_busca\": " << razao(ler(sondagens), ler(buscas))
+        << ",\n  \"rotacoes\": {\"insert\": " << ler(rotacoesInsert) << ", \"remove\": " << ler(rotacoesRemove)
+        << ", \"por_insert\": " << razao(ler(rotacoesInsert), ler(inserts))
+        << ", \"por_remove\": " << razao(ler(rotacoesRemove), ler(removes)) << "}"
+        << ",\n  \"nos\": {\"criados\": " << ler(ContagemNos::criados) << ", \"liberados\": "
+        << ler(ContagemNos::liberados) << "}"
+        << ",\n  \"profundidade\": {\"maxima\": " << alturaMax << ", \"media\": " << razao(soma, itensGavetas) << "}"
+        << ",\n  \"latencia_ns\": {";
+    const pair<const char*, const HistogramaLatencia*> hs[] = {{"insert", &latInsert}, {"busca", &latBusca},
+                                                               {"remove", &latRemove}};
+    for (size_t k = 0; k < 3; k++) {
+        Resumo r(*hs[k].second);
+        out << (k ? ", " : "") << "\n    \"" << hs[k].first << "\": {\"total\": " << r.total
+            << ", \"media\": " << razao(hs[k].second->somaNs(), r.total) << ", \"p50\": " << r.p(0.5)
+            << ", \"p90\": " << r.p(0.9) << ", \"p99\": " << r.p(0.99) << ", \"p999\": " << r.p(0.999)
+            << ", \"max\": " << hs[k].second->maximo() << "}";
+    }
+    out << "\n  },\n  \"gavetas_itens\": [";
+    for (size_t i = 0; i < gs->n; i++) out << (i ? ", " : "") << gs->g[i].itens.load(std::memory_order_relaxed);
+    out << "],\n  \"gavetas_altura\": [";
+    for (size_t i = 0; i < gs->n; i++) out << (i ? ", " : "") << gs->g[i].altura.load(std::memory_order_relaxed);
+    out << "]\n}\n";
+}
+
+// formato texto do Prometheus. Latencia vira histograma com limites fixos nas
+// potencias de 2 (caem sempre em borda de faixa, entao a contagem e exata)
+inline void EstatisticasTabela::prometheus(ostream& out, const string& prefixo) const {
+    auto ler = [](const std::atomic<uint64_t>& c) { return c.load(std::memory_order_relaxed); };
+    auto contador = [&](const string& nome, const string& ajuda) {
+        out << "# HELP " << prefixo << "_" << nome << " " << ajuda << "\n# TYPE " << prefixo << "_" << nome
+            << " counter\n";
+    };
+    auto medidor = [&](const string& nome, const string& ajuda) {
+        out << "# HELP " << prefixo << "_" << nome << " " << ajuda << "\n# TYPE " << prefixo << "_" << nome
+            << " gauge\n";
+    };
+    std::shared_ptr<Gavetas> gs = lerGavetas();
+
+    medidor("itens", "itens na tabela");
+    out << prefixo << "_itens " << ler(itens) << "\n";
+    contador("operacoes_total", "operacoes por tipo");
+    out << prefixo << "_operacoes_total{op=\"insert\"} " << ler(inserts) << "\n"
+        << prefixo << "_operacoes_total{op=\"busca\"} " << ler(buscas) << "\n"
+        << prefixo << "_operacoes_total{op=\"remove\"} " << ler(removes) << "\n";
+    contador("efetivas_total", "inserts de chave nova, buscas que acharam, removes que tiraram");
+    out << prefixo << "_efetivas_total{op=\"insert\"} " << ler(insertsNovos) << "\n"
+        << prefixo << "_efetivas_total{op=\"busca\"} " << ler(buscasAchadas) << "\n"
+        << prefixo << "_efetivas_total{op=\"remove\"} " << ler(removesAchados) << "\n";
+    contador("sondagens_total", "nos visitados nas buscas");
+    out << prefixo << "_sondagens_total " << ler(sondagens) << "\n";
+    contador("rotacoes_total", "rotacoes AVL");
+    out << prefixo << "_rotacoes_total{op=\"insert\"} " << ler(rotacoesInsert) << "\n"
+        << prefixo << "_rotacoes_total{op=\"remove\"} " << ler(rotacoesRemove) << "\n";
+    contador("nos_total", "nos de arvore criados e liberados um a um (processo todo)");
+    out << prefixo << "_nos_total{evento=\"criado\"} " << ler(ContagemNos::criados) << "\n"
+        << prefixo << "_nos_total{evento=\"liberado\"} " << ler(ContagemNos::liberados) << "\n";
+
+    medidor("gaveta_itens", "itens em cada gaveta");
+    for (size_t i = 0; i < gs->n; i++) {
+        out << prefixo << "_gaveta_itens{gaveta=\"" << i << "\"} " << gs->g[i].itens.load(std::memory_order_relaxed)
+            << "\n";
+    }
+    medidor("gaveta_altura", "altura da arvore de cada gaveta");
+    for (size_t i = 0; i < gs->n; i++) {
+        out << prefixo << "_gaveta_altura{gaveta=\"" << i << "\"} "
+            << gs->g[i].altura.load(std::memory_order_relaxed) << "\n";
+    }
+    int64_t itensGavetas = 0, soma = 0;
+    for (size_t i = 0; i < gs->n; i++) {
+        itensGavetas += gs->g[i].itens.load(std::memory_order_relaxed);
+        soma += gs->g[i].somaProfundidades.load(std::memory_order_relaxed);
+    }
+    medidor("profundidade_media", "profundidade media dos nos (raiz = 1)");
+    out << prefixo << "_profundidade_media " << (itensGavetas > 0 ? static_cast<double>(soma) / itensGavetas : 0.0)
+        << "\n";
+
+    out << "# HELP " << prefixo << "_latencia_ns latencia por operacao em ns\n# TYPE " << prefixo
+        << "_latencia_ns histogram\n";
+    const pair<const char*, const HistogramaLatencia*> hs[] = {{"insert", &latInsert}, {"busca", &latBusca},
+                                                               {"remove", &latRemove}};
+    for (const auto& h : hs) {
+        Resumo r(*h.second);
+        uint64_t acumulado = 0;
+        int f = 0;
+        for (int e = 4; e <= 34; e++) {
+            uint64_t limite = uint64_t(1) << e;
+            for (; f < HistogramaLatencia::FAIXAS && HistogramaLatencia::fimFaixa(f) < limite; f++) {
+                acumulado += r.c[f];
+            }
+            out << prefixo << "_latencia_ns_bucket{op=\"" << h.first << "\",le=\"" << limite - 1 << "\"} "
+                << acumulado << "\n";
+        }
+        out << prefixo << "_latencia_ns_bucket{op=\"" << h.first << "\",le=\"+Inf\"} " << r.total << "\n"
+            << prefixo << "_latencia_ns_sum{op=\"" << h.first << "\"} " << h.second->somaNs() << "\n"
+            << prefixo << "_latencia_ns_count{op=\"" << h.first << "\"} " << r.total << "\n";
+    }
+}
+
+// o que a tabela le da gaveta: BST tem contadores, os outros baldes ficam com zero
+template <typename Balde>
+ContadoresArvore contadoresDe(const Balde&) {
+    return ContadoresArvore();
+}
+template <typename T>
+const ContadoresArvore& contadoresDe(const BST<T>& arvore) {
+    return arvore.contadores();
+}
+#endif
+
+// Hash Table
+// HashPolicy: qual funcao de hash usar (padrao e a antiga, pra manter as gavetas iguais)
+// Balde: o que fica em cada gaveta. Padrao e a BST (AVL); BaldeEytzinger e a versao
+// plana (vetor contiguo). Precisa ter Insert/Remove/Search/size/altura/desenhar e os
+// ganchos do rehash (Esvaziar, InsertNode, itemDo) e da carga em lote.
+template <typename T, typename HashPolicy = HashLegado, typename Balde = BST<T>>
+class HashTable {
+private:
+    Balde** tabela; // cada gaveta: BST (AVL) por padrao, ou outro balde com a mesma cara
+    // edit
+    // motivo do ponteiro de ponteiro: qnd e ponteiro demora mt mais
+
+    //mudei de ponteiro de ponteiro pra ponteiro unico pq era meio desnecessario
+    //remover comentario depois
+    //ou nao
+    //alguem vai ler isso depois pode ser engracado seila
+    //diminuir nossa nota nao vai
+    //comentarios contam uma historia
+    template <typename K>
+    size_t Hash(const K& item);
+    size_t SIZE = 151;
+    HashPolicy politica;
+
+    // CRESCIMENTO: quando passa do fator de carga a tabela cresce pro proximo primo
+    // >= 2x o tamanho. O rehash e incremental: as gavetas velhas ficam em 'antiga'
+    // e cada insert/remove/search migra so 'passoMigracao' delas, sem pausa grande.
+    Balde** antiga = nullptr;
+    size_t SIZE_ANTIGA = 0;
+
+    // todos os nos de todas as arvores da tabela saem daqui
+    typename Balde::Arena arena;
+    // uma arena por thread na construcao paralela (deque: o endereco nao muda)
+    std::deque<typename Balde::Arena> arenasThreads;
+    size_t migradas = 0;       // gavetas da antiga que ja foram pra tabela nova
+#ifdef COM_ESTATISTICAS
+    EstatisticasTabela estat{151};
+    // indice na tabela nova (SIZE = a gaveta ainda ta na antiga e nao entra na conta)
+    size_t indiceGaveta(Balde* const* ref) const {
+        return ref >= tabela && ref < tabela + SIZE ? static_cast<size_t>(ref - tabela) : SIZE;
+    }
+    void publicarGaveta(size_t i) {
+        estat.itens.store(numItens, std::memory_order_relaxed);
+        if (i >= SIZE) return;
+        const Balde* arvore = tabela[i];
+        if (arvore == nullptr) {
+            estat.gaveta(i, 0, 0, 0);
+        } else {
+            estat.gaveta(i, arvore->size(), arvore->altura(), contadoresDe(*arvore).somaProfundidades);
+        }
+    }
+    // todas de novo (carga em lote, load, crescimento)
+    void publicarGavetas() {
+        estat.novasGavetas(SIZE);
+        for (size_t i = 0; i < SIZE; i++) publicarGaveta(i);
+    }
+#endif
+    size_t numItens = 0;
+    double fatorCarga = 0;     // itens por gaveta antes de crescer (0 = tamanho fixo)
+    size_t passoMigracao = 2;
+
+    template <typename K>
+    Balde*& gaveta(const K& item);
+    template <typename K>
+    void inserir(K&& item) { // K aqui e T (copia ou rvalue) ou string_view
+        inserir(std::forward<K>(item), [](const T&) {});
+    }
+    // insere (se nao tiver) e entrega o item da arvore pro noItem antes de crescer
+    // a tabela (crescer pode mudar o item de lugar)
+    template <typename K, typename F>
+    void inserir(K&& item, F&& noItem);
+    // todas as arvores com item (inclusive as da antiga que ainda nao migraram)
+    template <typename F>
+    void paraCadaBalde(F visitar) const;
+    // coletar(balde, guardar) chama guardar em ordem pros itens daquele balde; o
+    // resultado sai com tudo junto em ordem
+    template <typename F>
+    vector<const T*> juntarGavetas(F coletar) const;
+    void crescer();
+    void limparTudo(size_t gavetas); // solta tudo e recomeca vazia com 'gavetas'
+    void migrarPasso();
+    void migrarGaveta(size_t i);
+public:
+    template <typename K>
+    void insert(const K& item); // T ou string_view (so aloca se a palavra for nova)
+    void insert(T&& item) { inserir(std::move(item)); } // vai movida pro no (se for nova)
+    // INSERT EM LOTE: da o mesmo resultado de um insert pra cada chave, na ordem. Quando
+    // nao tem rehash no meio e a tabela nao vai crescer durante o lote, agrupa por
+    // gaveta antes: cada arvore recebe as palavras dela juntas (na mesma ordem de
+    // antes, entao a forma e a mesma) e fica no cache em vez de pular de gaveta em gaveta.
+    template <typename K>
+    void insertMany(const K* chaves, size_t n);
+    // monta o T uma vez com os argumentos e move pro no
+    template <typename... Args>
+    void emplace(Args&&... args) { inserir(T(std::forward<Args>(args)...)); }
+    void remove(const T& item); //na teoria nao precisa remover nada pra fazer o que precisa no hackerrank..
+    //mas agora vou tentar fazer funcionar
+    // search e buscarMostrarAltura aceitam T, string_view, const char*...
+    // (qualquer coisa com visaoChave), a busca roda direto na view sem montar string
+    template <typename K>
+    bool search(const K& item); // to fazendo retornar o proprio nó
+    // o item guardado com essa chave (ou nullptr). Vale ate a proxima mudanca na tabela
+    template <typename K>
+    const T* find(const K& item);
+    // BUSCA EM LOTE: resultados[i] = search(chaves[i]), mas escondendo a latencia da
+    // memoria. Vai em blocos: primeiro calcula o hash do bloco todo e pede as gavetas,
+    // depois as arvores, depois as raizes (cada etapa pede a memoria da seguinte), e
+    // desce varias arvores ao mesmo tempo, um nivel de cada por vez, pedindo o proximo
+    // no antes de voltar nele. Com balde que nao e BST, ou lote de menos de 4 (o preparo
+    // das etapas custa mais do que esconde), cai no search um por um.
+    template <typename K>
+    void searchMany(const K* chaves, size_t n, bool* resultados);
+    int length();
+    bool empty();
+
+    template <typename K>
+    auto buscarMostrarAltura(const K& key);
+
+    // visita todos os itens (cada gaveta em ordem, as gavetas sem ordem nenhuma)
+    template <typename F>
+    void paraCada(F visitar) const;
+    // todos os itens em ordem global, sem imprimir (mescla das gavetas por heap)
+    MesclaGavetas<T, Balde> ordenada() const;
+
+    // MODO MAPA (T = EntradaMapa<K, V>): contagem de palavras numa passada so.
+    // increment insere a chave com V() se for nova e soma delta no valor, na mesma
+    // descida do insert. Devolve o valor novo.
+    template <typename K, typename D = int>
+    auto increment(const K& chave, D delta = 1);
+    // valor da chave numa busca so (V() se nao tiver)
+    template <typename K>
+    auto frequencia(const K& chave);
+    // os k de maior valor (empate: chave menor primeiro), do maior pro menor.
+    // Heap de k itens em vez de ordenar tudo: O(n log k). Os ponteiros apontam pra
+    // dentro da tabela (valem ate a proxima mudanca).
+    vector<const T*> topK(size_t k) const;
+
+    // CONSULTAS DE FAIXA: o hash espalha as chaves, entao toda gaveta responde (cada
+    // uma em O(log n) pelo tamanho das subarvores) e as respostas sao somadas ou
+    // juntadas em ordem. Faixa e fechada: de <= item <= ate.
+    template <typename K1, typename K2>
+    size_t countRange(const K1& de, const K2& ate) const;
+    size_t countPrefix(std::string_view prefixo) const;
+    // os itens em ordem (ponteiros pra dentro da tabela, valem ate a proxima mudanca)
+    template <typename K1, typename K2>
+    vector<const T*> faixa(const K1& de, const K2& ate) const;
+    vector<const T*> comPrefixo(std::string_view prefixo) const;
+
+    // sem argumento: 151 gavetas e nunca cresce (igual sempre foi)
+    HashTable() : HashTable(151) {}
+    explicit HashTable(size_t gavetasIniciais, double fatorCarga = 0, size_t passoMigracao = 2) {
+        SIZE = gavetasIniciais;
+        this->fatorCarga = fatorCarga;
+        this->passoMigracao = passoMigracao > 0 ? passoMigracao : 1;
+        tabela = new Balde*[SIZE];
+
+        // deixar geral nullptr para existir as 'gavetas'
+        for (size_t i = 0; i < SIZE; i++) {
+            tabela[i] = nullptr;
+        }
+        SO_ESTATISTICA(estat.novasGavetas(SIZE);)
+    }
+    ~HashTable() {
+        // as arvores nao precisam soltar no por no: a arena libera tudo em bloco
+        for (size_t i = 0; i < SIZE; i++) {
+            if (tabela[i] != nullptr) {
+                tabela[i]->Abandonar();
+                delete tabela[i];
+            }
+        }
+        delete[] tabela;
+        if (antiga != nullptr) {
+            for (size_t i = migradas; i < SIZE_ANTIGA; i++) {
+                if (antiga[i] != nullptr) {
+                    antiga[i]->Abandonar();
+                    delete antiga[i];
+                }
+            }
+            delete[] antiga;
+        }
+    }
+    HashTable(const HashTable&) = delete;
+    HashTable& operator=(const HashTable&) = delete;
+
+    // CARGA EM LOTE: separa as chaves por gaveta, ordena e tira repetidas em cada uma
+    // e monta cada arvore de uma vez (BST::CarregarOrdenado) em vez de N inserts com
+    // rotacao. As chaves (strings ou views) tem que continuar vivas durante a chamada.
+    // No modo mapa quem ja estava na tabela fica com o valor; chave nova comeca em V().
+    template <typename Range>
+    void bulkLoad(const Range& chaves);
+
+    // SNAPSHOT (formato la embaixo, junto da SnapshotTabela): save grava a tabela
+    // inteira com a forma exata de cada arvore (termina o rehash antes, se tiver um no
+    // meio); load troca o conteudo pelo do arquivo montando cada arvore direto na forma
+    // salva, sem comparar nem rotacionar nada. So pra gaveta BST e T que se monta de
+    // string_view; o modo mapa nao compila (o arquivo so tem as chaves e os valores
+    // voltariam zerados). false = nao deu (arquivo, versao, politica de hash, checksum
+    // ou forma das arvores errados).
+    bool save(const string& caminho);
+    bool load(const string& caminho);
+
+    // CONSTRUCAO PARALELA: o texto e dividido em pedacos (sempre em espaco) e cada
+    // thread quebra o seu e manda cada palavra pra fila da thread dona da gaveta
+    // (faixas de gavetas separadas). Depois cada dona insere nas suas gavetas, pedaco
+    // por pedaco na ordem do texto: cada arvore recebe as palavras na mesma ordem do
+    // jeito serial, entao o resultado e identico, e ninguem precisa de lock.
+    // Cada thread usa uma arena propria. Com fator de carga ligado, a tabela so
+    // cresce depois (a construcao em si e no tamanho atual).
+    void construirParalelo(std::string_view texto, unsigned numThreads);
+
+    // mesmas gavetas com arvores do mesmo formato (itens e alturas em pre-ordem)
+    bool mesmaEstrutura(const HashTable& outra) const;
+
+#ifdef COM_ESTATISTICAS
+    // contadores, gavetas e histogramas (ver EstatisticasTabela): pode exportar de outra
+    // thread enquanto esta usa a tabela
+    const EstatisticasTabela& estatisticas() const { return estat; }
+    // o que foi publicado bate com as arvores (soma das profundidades percorrendo tudo)
+    bool conferirEstatisticas() const;
+#endif
+
+    size_t gavetas() const { return SIZE; }
+    bool conferirArvores() const; // todas as gavetas passam no BST::ConferirAVL
+    bool migrando() const { return antiga != nullptr; }
+    void setFatorCarga(double fator) { fatorCarga = fator; }
+
+    // memoria dos nos: reservado nos blocos x realmente em uso
+    size_t bytesReservados() const {
+        size_t total = arena.bytesReservados();
+        for (const auto& a : arenasThreads) total += a.bytesReservados();
+        return total;
+    }
+    size_t bytesVivos() const {
+        size_t total = arena.bytesVivos();
+        for (const auto& a : arenasThreads) total += a.bytesVivos();
+        return total;
+    }
+};
+
+// HashTable<K, V> do modo mapa: ex. MapaHash<string, size_t> conta palavras
+template <typename K, typename V, typename HashPolicy = HashLegado>
+using MapaHash = HashTable<EntradaMapa<K, V>, HashPolicy>;
+
+// primeiro primo >= n (tamanho novo da tabela)
+inline size_t proximoPrimo(size_t n) {
+    if (n <= 2) return 2;
+    if (n % 2 == 0) n++;
+    for (;; n += 2) {
+        bool primo = true;
+        for (size_t d = 3; d * d <= n; d += 2) {
+            if (n % d == 0) {
+                primo = false;
+                break;
+            }
+        }
+        if (primo) return n;
+    }
+}
+
+// acha a gaveta certa: se a gaveta velha dele ainda nao migrou, ta na antiga
+template <typename T, typename HashPolicy, typename Balde>
+template <typename K>
+Balde*& HashTable<T, HashPolicy, Balde>::gaveta(const K& item) {
+    if (antiga != nullptr) {
+        size_t i = politica(visaoChave(item), SIZE_ANTIGA);
+        if (i >= migradas) {
+            return antiga[i];
+        }
+    }
+    return tabela[Hash(item)];
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+void HashTable<T, HashPolicy, Balde>::migrarGaveta(size_t i) {
+    Balde* velha = antiga[i];
+    antiga[i] = nullptr;
+    if (velha == nullptr) {
+        return;
+    }
+    // os nos mudam de arvore sem alocar de novo
+    velha->Esvaziar([this](auto no) {
+        Balde*& destino = tabela[Hash(Balde::itemDo(no))];
+        if (destino == nullptr) {
+            destino = new Balde(&arena);
+        }
+        destino->InsertNode(no);
+        SO_ESTATISTICA(publicarGaveta(indiceGaveta(&destino));)
+    });
+    delete velha;
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+void HashTable<T, HashPolicy, Balde>::migrarPasso() {
+    if (antiga == nullptr) {
+        return;
+    }
+    for (size_t k = 0; k < passoMigracao && migradas < SIZE_ANTIGA; k++) {
+        migrarGaveta(migradas++);
+    }
+    if (migradas == SIZE_ANTIGA) {
+        delete[] antiga;
+        antiga = nullptr;
+        SIZE_ANTIGA = 0;
+        migradas = 0;
+    }
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+void HashTable<T, HashPolicy, Balde>::limparTudo(size_t gavetas) {
+    // igual o destrutor: os nos somem junto com as arenas
+    for (size_t i = 0; i < SIZE; i++) {
+        if (tabela[i] != nullptr) {
+            tabela[i]->Abandonar();
+            delete tabela[i];
+        }
+    }
+    delete[] tabela;
+    if (antiga != nullptr) {
+        for (size_t i = migradas; i < SIZE_ANTIGA; i++) {
+            if (antiga[i] != nullptr) {
+                antiga[i]->Abandonar();
+                delete antiga[i];
+            }
+        }
+        delete[] antiga;
+        antiga = nullptr;
+        SIZE_ANTIGA = 0;
+        migradas = 0;
+    }
+    arena.clear();
+    arenasThreads.clear();
+    numItens = 0;
+    SIZE = gavetas;
+    tabela = new Balde*[SIZE]();
+    SO_ESTATISTICA(publicarGavetas();)
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+void HashTable<T, HashPolicy, Balde>::crescer() {
+    // se ainda tava migrando (cresceu rapido demais), termina antes
+    while (antiga != nullptr) {
+        migrarPasso();
+    }
+    antiga = tabela;
+    SIZE_ANTIGA = SIZE;
+    migradas = 0;
+    SIZE = proximoPrimo(2 * SIZE);
+    tabela = new Balde*[SIZE];
+    for (size_t i = 0; i < SIZE; i++) {
+        tabela[i] = nullptr;
+    }
+    SO_ESTATISTICA(publicarGavetas();) // as gavetas novas enchem conforme a migracao anda
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+template <typename Range>
+void HashTable<T, HashPolicy, Balde>::bulkLoad(const Range& chaves) {
+    while (antiga != nullptr) {
+        migrarPasso();
+    }
+
+    // 1) tira as repetidas antes de tudo, com um conjunto de enderecamento aberto
+    // marcado por um hash de 64 bits (texto repete muito palavra: o hash da tabela
+    // e a ordenacao so rodam nas distintas)
+    size_t total = 0;
+    for (auto it = std::begin(chaves); it != std::end(chaves); ++it) {
+        total++;
+    }
+    size_t capacidade = 16;
+    while (capacidade < 2 * total) capacidade *= 2;
+    vector<uint64_t> marcas(capacidade, 0);
+    vector<uint32_t> posicao(capacidade);
+    vector<std::string_view> unicas;
+    HashMistura64 marcador;
+    for (const auto& chave : chaves) {
+        std::string_view v = visaoChave(chave);
+        uint64_t marca = marcador(v, ~size_t(0)) | 1; // 0 = slot vazio
+        size_t slot = marca & (capacidade - 1);
+        while (marcas[slot] != 0 && !(marcas[slot] == marca && unicas[posicao[slot]] == v)) {
+            slot = (slot + 1) & (capacidade - 1);
+        }
+        if (marcas[slot] == 0) {
+            marcas[slot] = marca;
+            posicao[slot] = static_cast<uint32_t>(unicas.size());
+            unicas.push_back(v);
+        }
+    }
+
+    // se cresce, ja cresce tudo agora (pior caso: nenhuma ja estava na tabela)
+    if (fatorCarga > 0) {
+        while (numItens + unicas.size() > fatorCarga * SIZE) {
+            crescer();
+            while (antiga != nullptr) {
+                migrarPasso();
+            }
+        }
+    }
+
+    // 2) counting sort pelas gavetas: conta, acumula e espalha num vetor so
+    vector<uint32_t> indices(unicas.size());
+    vector<size_t> inicio(SIZE + 1, 0);
+    for (size_t k = 0; k < unicas.size(); k++) {
+        indices[k] = static_cast<uint32_t>(Hash(unicas[k]));
+        inicio[indices[k] + 1]++;
+    }
+    for (size_t i = 0; i < SIZE; i++) {
+        inicio[i + 1] += inicio[i];
+    }
+    vector<std::string_view> particao(unicas.size());
+    vector<size_t> proximo(inicio.begin(), inicio.end() - 1);
+    for (size_t k = 0; k < unicas.size(); k++) {
+        particao[proximo[indices[k]]++] = unicas[k];
+    }
+
+    // 3) cada gaveta: ordena e monta a arvore de uma vez
+    vector<std::string_view> existentes;
+    vector<std::string_view> juntas;
+    for (size_t i = 0; i < SIZE; i++) {
+        if (inicio[i] == inicio[i + 1]) continue;
+        auto comeco = particao.begin() + inicio[i];
+        auto fim = particao.begin() + inicio[i + 1];
+        sort(comeco, fim);
+
+        Balde* velha = tabela[i];
+        Balde* nova = new Balde(&arena);
+        if (velha == nullptr || velha->size() == 0) {
+            nova->CarregarOrdenado(comeco, fim);
+        } else {
+            // ja tinha coisa: junta o que tinha (em ordem) com as novas
+            existentes.clear();
+            juntas.clear();
+            velha->EmOrdem([&](const T& item) { existentes.push_back(visaoChave(item)); });
+            std::set_union(existentes.begin(), existentes.end(), comeco, fim, back_inserter(juntas));
+            nova->CarregarOrdenado(juntas.begin(), juntas.end());
+            if constexpr (ehEntradaMapa<T>::value) {
+                // a nova foi montada so das chaves: os valores vem da velha (as duas em
+                // ordem e a velha esta toda dentro da nova, entao e uma passada so)
+                auto antigo = velha->begin();
+                nova->EmOrdem([&](const T& item) {
+                    if (antigo != velha->end() && comparar(*antigo, item) == 0) {
+                        item.valor = std::move(antigo->valor);
+                        ++antigo;
+                    }
+                });
+            }
+            numItens -= velha->size();
+        }
+        delete velha; // so depois de montar a nova: as views apontavam pros nos dela
+        tabela[i] = nova;
+        numItens += nova->size();
+    }
+    SO_ESTATISTICA(publicarGavetas();)
+}
+
+#ifdef COM_ESTATISTICAS
+template <typename T, typename HashPolicy, typename Balde>
+bool HashTable<T, HashPolicy, Balde>::conferirEstatisticas() const {
+    std::shared_ptr<EstatisticasTabela::Gavetas> gs = estat.lerGavetas();
+    if (gs->n != SIZE || estat.itens.load() != numItens) return false;
+    for (size_t i = 0; i < SIZE; i++) {
+        const EstatisticasTabela::Gaveta& g = gs->g[i];
+        const Balde* arvore = tabela[i];
+        int64_t itens = arvore != nullptr ? arvore->size() : 0;
+        int64_t altura = arvore != nullptr ? arvore->altura() : 0;
+        if (g.itens.load() != itens || g.altura.load() != altura) return false;
+        if constexpr (std::is_same<Balde, BST<T>>::value) {
+            int64_t soma = arvore != nullptr ? arvore->SomarProfundidades() : 0;
+            if (arvore != nullptr && arvore->contadores().somaProfundidades != soma) return false;
+            if (g.somaProfundidades.load() != soma) return false;
+        }
+    }
+    return true;
+}
+#endif
+
+template <typename T, typename HashPolicy, typename Balde>
+bool HashTable<T, HashPolicy, Balde>::mesmaEstrutura(const HashTable& outra) const {
+    if (SIZE != outra.SIZE || numItens != outra.numItens || antiga != nullptr || outra.antiga != nullptr) {
+        return false;
+    }
+    vector<pair<const T*, int>> a;
+    vector<pair<const T*, int>> b;
+    for (size_t i = 0; i < SIZE; i++) {
+        a.clear();
+        b.clear();
+        if (tabela[i] != nullptr) {
+            tabela[i]->EmPreOrdem([&](const BSTNode<T>& no) { a.push_back({&no.getItem(), no.getHeight()}); });
+        }
+        if (outra.tabela[i] != nullptr) {
+            outra.tabela[i]->EmPreOrdem([&](const BSTNode<T>& no) { b.push_back({&no.getItem(), no.getHeight()}); });
+        }
+        if (a.size() != b.size()) return false;
+        for (size_t k = 0; k < a.size(); k++) {
+            if (a[k].second != b[k].second || comparar(*a[k].first, *b[k].first) != 0) return false;
+        }
+    }
+    return true;
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+bool HashTable<T, HashPolicy, Balde>::conferirArvores() const {
+    for (size_t i = 0; i < SIZE; i++) {
+        if (tabela[i] != nullptr && !tabela[i]->ConferirAVL()) return false;
+    }
+    for (size_t i = migradas; antiga != nullptr && i < SIZE_ANTIGA; i++) {
+        if (antiga[i] != nullptr && !antiga[i]->ConferirAVL()) return false;
+    }
+    return true;
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+int HashTable<T, HashPolicy, Balde>::length() {
+    return static_cast<int>(numItens);
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+bool HashTable<T, HashPolicy, Balde>::empty() {
+    return numItens == 0;
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+template <typename K>
+auto HashTable<T, HashPolicy, Balde>::buscarMostrarAltura(const K& key) {
+    std::string_view chave = visaoChave(key);
+    migrarPasso();
+    Balde* arvore = gaveta(chave);
+
+    // ja ve se existe algo
+    if (arvore == nullptr) {
+        return -1;
+    }
+
+    // a arvore gerada com o codigo hash, agora procura a chave nela
+    auto noAchado = arvore->Search(chave);
+
+    // nao achou ouu achou?
     if (noAchado == nullptr) {
         return -1;
     }
 
-    // DEBUG: PRINTAR CODIGO DOT PARA ARVORE
-    cout << "CODIGO DOT DE: " << noAchado->getItem() << endl;
-    tabela[indice]->drawTree(arvore->getRoot());
-    cout << endl;
-    return arvore->getRoot()->getHeight();
+    // DEBUG: PRINTAR CODIGO DOT PARA ARVORE
+    cout << "CODIGO DOT DE: " << chave << endl; // achou: e a mesma palavra do no
+    arvore->desenhar();
+    cout << endl;
+    return arvore->altura();
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+template <typename K>
+// a conta em si agora fica na politica (ver HashLegado)
+size_t HashTable<T, HashPolicy, Balde>::Hash(const K& key) {
+    return politica(visaoChave(key), SIZE);
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+template <typename K>
+void HashTable<T, HashPolicy, Balde>::insert(const K& item) {
+    // T vai direto; o resto (string_view, const char*...) vira view
+    if constexpr (std::is_same<K, T>::value) {
+        inserir(item);
+    } else {
+        inserir(visaoChave(item));
+    }
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+template <typename K, typename F>
+void HashTable<T, HashPolicy, Balde>::inserir(K&& item, F&& noItem) {
+    SO_ESTATISTICA(auto inicioOp = chrono::steady_clock::now();)
+    migrarPasso();
+    Balde*& arvore = gaveta(item);
+    // garantindo que existe kkk
+    if (arvore == nullptr) {
+        arvore = new Balde(&arena);
+    }
+
+    int antes = arvore->size();
+    SO_ESTATISTICA(ContadoresArvore contAntes = contadoresDe(*arvore);)
+    noItem(arvore->InsertOuAcha(std::forward<K>(item)));
+    numItens += arvore->size() - antes;
+    SO_ESTATISTICA(estat.registrarInsert(contAntes, contadoresDe(*arvore), arvore->size() != antes);
+                   publicarGaveta(indiceGaveta(&arvore));)
+
+    if (fatorCarga > 0 && numItens > fatorCarga * SIZE) {
+        crescer();
+    }
+    SO_ESTATISTICA(estat.latInsert.registrar(EstatisticasTabela::desde(inicioOp));)
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+void HashTable<T, HashPolicy, Balde>::remove(const T& item) {
+    SO_ESTATISTICA(auto inicioOp = chrono::steady_clock::now();)
+    migrarPasso();
+    Balde*& arvore = gaveta(item);
+
+    if (arvore == nullptr) {
+        SO_ESTATISTICA(estat.registrarRemove({}, {}, false);
+                       estat.latRemove.registrar(EstatisticasTabela::desde(inicioOp));)
+        return;
+    }
+
+    int antes = arvore->size();
+    SO_ESTATISTICA(ContadoresArvore contAntes = contadoresDe(*arvore);)
+    arvore->Remove(item);
+    numItens -= antes - arvore->size();
+    SO_ESTATISTICA(estat.registrarRemove(contAntes, contadoresDe(*arvore), arvore->size() != antes);
+                   publicarGaveta(indiceGaveta(&arvore));
+                   estat.latRemove.registrar(EstatisticasTabela::desde(inicioOp));)
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+template <typename K>
+bool HashTable<T, HashPolicy, Balde>::search(const K& key) {
+    return find(key) != nullptr;
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+template <typename K>
+const T* HashTable<T, HashPolicy, Balde>::find(const K& key) {
+    SO_ESTATISTICA(auto inicioOp = chrono::steady_clock::now();)
+    std::string_view item = visaoChave(key);
+    migrarPasso();
+    Balde* arvore = gaveta(item);
+
+    if (arvore == nullptr) {
+        SO_ESTATISTICA(estat.registrarBusca({}, {}, false);
+                       estat.latBusca.registrar(EstatisticasTabela::desde(inicioOp));)
+        return nullptr;
+    }
+
+    SO_ESTATISTICA(ContadoresArvore contAntes = contadoresDe(*arvore);)
+    auto temp = arvore->Search(item);
+    SO_ESTATISTICA(estat.registrarBusca(contAntes, contadoresDe(*arvore), temp != nullptr);
+                   estat.latBusca.registrar(EstatisticasTabela::desde(inicioOp));)
+
+    if (temp == nullptr) {
+        return nullptr;
+    }
+
+    return &Balde::itemDo(temp); // Search so devolve no com a chave igual, nao precisa comparar de novo
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+template <typename F>
+void HashTable<T, HashPolicy, Balde>::paraCadaBalde(F visitar) const {
+    for (size_t i = 0; i < SIZE; i++) {
+        if (tabela[i] != nullptr) visitar(*tabela[i]);
+    }
+    for (size_t i = migradas; antiga != nullptr && i < SIZE_ANTIGA; i++) {
+        if (antiga[i] != nullptr) visitar(*antiga[i]);
+    }
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+template <typename F>
+void HashTable<T, HashPolicy, Balde>::paraCada(F visitar) const {
+    paraCadaBalde([&](const Balde& balde) { balde.EmOrdem(visitar); });
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+MesclaGavetas<T, Balde> HashTable<T, HashPolicy, Balde>::ordenada() const {
+    MesclaGavetas<T, Balde> mescla(SIZE + (antiga != nullptr ? SIZE_ANTIGA - migradas : 0));
+    paraCadaBalde([&](const Balde& balde) { mescla.adicionar(balde); });
+    mescla.preparar();
+    return mescla;
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+template <typename F>
+vector<const T*> HashTable<T, HashPolicy, Balde>::juntarGavetas(F coletar) const {
+    vector<const T*> itens;
+    vector<size_t> cortes{0}; // cada balde deixa uma sequencia ordenada [cortes[j], cortes[j+1])
+    paraCadaBalde([&](const Balde& balde) {
+        coletar(balde, [&](const T& item) { itens.push_back(&item); });
+        if (itens.size() != cortes.back()) cortes.push_back(itens.size());
+    });
+    // junta as sequencias de duas em duas: cada rodada divide o numero delas por 2
+    auto menor = [](const T* a, const T* b) { return comparar(*a, *b) < 0; };
+    while (cortes.size() > 2) {
+        vector<size_t> juntos{0};
+        for (size_t j = 0; j + 1 < cortes.size(); j += 2) {
+            if (j + 2 < cortes.size()) {
+                inplace_merge(itens.begin() + cortes[j], itens.begin() + cortes[j + 1],
+                              itens.begin() + cortes[j + 2], menor);
+                juntos.push_back(cortes[j + 2]);
+            } else {
+                juntos.push_back(cortes[j + 1]); // sobrou uma sem par
+            }
+        }
+        cortes.swap(juntos);
+    }
+    return itens;
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+template <typename K1, typename K2>
+size_t HashTable<T, HashPolicy, Balde>::countRange(const K1& de, const K2& ate) const {
+    std::string_view inicio = visaoChave(de);
+    std::string_view fim = visaoChave(ate);
+    size_t total = 0;
+    paraCadaBalde([&](const Balde& balde) { total += balde.CountRange(inicio, fim); });
+    return total;
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+size_t HashTable<T, HashPolicy, Balde>::countPrefix(std::string_view prefixo) const {
+    size_t total = 0;
+    paraCadaBalde([&](const Balde& balde) { total += balde.CountPrefix(prefixo); });
+    return total;
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+template <typename K1, typename K2>
+vector<const T*> HashTable<T, HashPolicy, Balde>::faixa(const K1& de, const K2& ate) const {
+    std::string_view inicio = visaoChave(de);
+    std::string_view fim = visaoChave(ate);
+    return juntarGavetas([&](const Balde& balde, auto guardar) { balde.EmFaixa(inicio, fim, guardar); });
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+vector<const T*> HashTable<T, HashPolicy, Balde>::comPrefixo(std::string_view prefixo) const {
+    return juntarGavetas([&](const Balde& balde, auto guardar) { balde.EmPrefixo(prefixo, guardar); });
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+template <typename K, typename D>
+auto HashTable<T, HashPolicy, Balde>::increment(const K& chave, D delta) {
+    decltype(T::valor) novo{};
+    inserir(visaoChave(chave), [&](const T& e) {
+        e.valor += delta;
+        novo = e.valor;
+    });
+    return novo;
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+template <typename K>
+auto HashTable<T, HashPolicy, Balde>::frequencia(const K& chave) {
+    const T* e = find(chave);
+    return e != nullptr ? e->valor : decltype(T::valor){};
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+vector<const T*> HashTable<T, HashPolicy, Balde>::topK(size_t k) const {
+    // a vem antes de b no resultado?
+    auto antes = [](const T* a, const T* b) {
+        if (a->valor != b->valor) return b->valor < a->valor;
+        return comparar(*a, *b) < 0;
+    };
+    // heap com o pior dos k no topo: so entra quem for melhor que ele
+    vector<const T*> heap;
+    k = min(k, numItens);
+    if (k == 0) return heap;
+    heap.reserve(k);
+    paraCada([&](const T& e) {
+        if (heap.size() < k) {
+            heap.push_back(&e);
+            push_heap(heap.begin(), heap.end(), antes);
+        } else if (antes(&e, heap.front())) {
+            pop_heap(heap.begin(), heap.end(), antes);
+            heap.back() = &e;
+            push_heap(heap.begin(), heap.end(), antes);
+        }
+    });
+    sort_heap(heap.begin(), heap.end(), antes);
+    return heap;
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+template <typename K>
+void HashTable<T, HashPolicy, Balde>::insertMany(const K* chaves, size_t n) {
+    if (antiga != nullptr || (fatorCarga > 0 && numItens + n > fatorCarga * SIZE)) {
+        // o rehash/crescimento depende de quando cada insert acontece: vai um por um
+        for (size_t i = 0; i < n; i++) {
+            inserir(visaoChave(chaves[i]));
+        }
+        return;
+    }
+    SO_ESTATISTICA(auto inicioLote = chrono::steady_clock::now();)
+    // (gaveta, posicao no lote): ordenar o par mantem a ordem do lote dentro da gaveta
+    vector<pair<uint32_t, uint32_t>> ordem(n);
+    for (size_t i = 0; i < n; i++) {
+        ordem[i] = {static_cast<uint32_t>(Hash(chaves[i])), static_cast<uint32_t>(i)};
+    }
+    sort(ordem.begin(), ordem.end());
+    for (const auto& par : ordem) {
+        Balde*& arvore = tabela[par.first];
+        if (arvore == nullptr) {
+            arvore = new Balde(&arena);
+        }
+        int antes = arvore->size();
+        SO_ESTATISTICA(ContadoresArvore contAntes = contadoresDe(*arvore);)
+        arvore->Insert(visaoChave(chaves[par.second]));
+        numItens += arvore->size() - antes;
+        SO_ESTATISTICA(estat.registrarInsert(contAntes, contadoresDe(*arvore), arvore->size() != antes);
+                       publicarGaveta(par.first);)
+    }
+    // latencia: o lote inteiro dividido pelas chaves (por chave nao da, elas vao misturadas)
+    SO_ESTATISTICA(estat.latInsert.registrarLote(EstatisticasTabela::desde(inicioLote), n);)
+}
+
+template<typename T, typename HashPolicy, typename Balde>
+template <typename K>
+void HashTable<T, HashPolicy, Balde>::searchMany(const K* chaves, size_t n, bool* resultados) {
+    const size_t LOTE_MINIMO = 4;
+    if (!std::is_same<Balde, BST<T>>::value || n < LOTE_MINIMO) {
+        for (size_t i = 0; i < n; i++) {
+            resultados[i] = search(chaves[i]);
+        }
+        return;
+    }
+    if constexpr (std::is_same<Balde, BST<T>>::value) {
+        SO_ESTATISTICA(auto inicioLote = chrono::steady_clock::now();
+                       uint64_t achadasLote = 0;
+                       uint64_t sondagensLote = 0;)
+        migrarPasso(); // uma vez pro lote (o search faz uma por chamada)
+        const size_t BLOCO = 64; // chaves por etapa: distancia entre pedir e usar
+        const size_t GRUPO = 16; // arvores descendo juntas
+
+        std::string_view visoes[BLOCO];
+        Balde** gavetasBloco[BLOCO];
+        BSTNode<T>* raizes[BLOCO];
+        struct Busca {
+            std::string_view chave;
+            BSTNode<T>* node;
+            size_t indice;
+        };
+        Busca ativas[GRUPO];
+
+        for (size_t base = 0; base < n; base += BLOCO) {
+            size_t m = n - base < BLOCO ? n - base : BLOCO;
+            // etapa 1: hash de todas e pede a posicao da gaveta
+            for (size_t k = 0; k < m; k++) {
+                visoes[k] = visaoChave(chaves[base + k]);
+                gavetasBloco[k] = &gaveta(visoes[k]);
+                __builtin_prefetch(gavetasBloco[k]);
+            }
+            // etapa 2: pede o objeto da arvore
+            for (size_t k = 0; k < m; k++) {
+                if (*gavetasBloco[k] != nullptr) __builtin_prefetch(*gavetasBloco[k]);
+            }
+            // etapa 3: pega a raiz e pede ela
+            for (size_t k = 0; k < m; k++) {
+                raizes[k] = *gavetasBloco[k] != nullptr ? (*gavetasBloco[k])->getRoot() : nullptr;
+                if (raizes[k] != nullptr) {
+                    __builtin_prefetch(raizes[k]);
+                    __builtin_prefetch(&raizes[k]->getItem());
+                }
+            }
+            // etapa 3b: com a raiz ja chegando, pede o texto da chave dela (string maior
+            // que o SSO mora fora do no, no heap)
+            for (size_t k = 0; k < m; k++) {
+                if (raizes[k] != nullptr) __builtin_prefetch(visaoChave(raizes[k]->getItem()).data());
+            }
+            // etapa 4: desce GRUPO arvores intercaladas; quem termina ja puxa a proxima chave.
+            // Daqui pra baixo so o no e pedido antes: o texto de chave longa fica atras do
+            // no (precisa dele pra saber o endereco), entao continua uma espera por nivel
+            // nessas chaves. Palavra curta cabe no SSO e vem junto com o no.
+            size_t proxima = 0;
+            size_t numAtivas = 0;
+            while (numAtivas < GRUPO && proxima < m) {
+                ativas[numAtivas++] = {visoes[proxima], raizes[proxima], base + proxima};
+                proxima++;
+            }
+            while (numAtivas > 0) {
+                for (size_t s = 0; s < numAtivas;) {
+                    Busca& b = ativas[s];
+                    bool terminou = false;
+                    if (b.node == nullptr) {
+                        resultados[b.indice] = false;
+                        terminou = true;
+                    } else {
+                        SO_ESTATISTICA(sondagensLote++;)
+                        int cmp = comparar(b.chave, b.node->getItem());
+                        if (cmp == 0) {
+                            resultados[b.indice] = true;
+                            SO_ESTATISTICA(achadasLote++;)
+                            terminou = true;
+                        } else {
+                            b.node = cmp < 0 ? b.node->getLeft() : b.node->getRight();
+                            if (b.node != nullptr) {
+                                __builtin_prefetch(b.node);
+                                __builtin_prefetch(&b.node->getItem());
+                            }
+                        }
+                    }
+                    if (!terminou) {
+                        s++;
+                    } else if (proxima < m) {
+                        b = {visoes[proxima], raizes[proxima], base + proxima};
+                        proxima++;
+                        s++;
+                    } else {
+                        b = ativas[--numAtivas]; // a ultima vem pra ca e roda nessa mesma volta
+                    }
+                }
+            }
+        }
+        SO_ESTATISTICA(estat.registrarBuscas(n, achadasLote, sondagensLote);
+                       estat.latBusca.registrarLote(EstatisticasTabela::desde(inicioLote), n);)
+    }
+}
+
+// TABELA HASH CONCORRENTE
+// Mesma ideia da HashTable (gavetas com arvore AVL), mas segura pra varias threads:
+// as gavetas sao divididas em faixas e cada faixa tem um shared_mutex (leitores em
+// paralelo, escritor sozinho) e uma arena propria. Leitura em gavetas de faixas
+// diferentes nunca disputa, e um insert so trava a faixa da gaveta dele.
+// Tamanho fixo (sem rehash): os nos nunca mudam de faixa.
+// Poucas faixas (64 a 256, nao uma por gaveta): cada arena ja reserva um bloco de
+// 64 KiB no primeiro no, entao a memoria cresce com as faixas e nao com as gavetas.
+template <typename T, typename HashPolicy = HashLegado>
+class HashTableConcorrente {
+private:
+    // uma linha de cache por faixa pra uma trava nao derrubar a vizinha
+    struct alignas(64) Faixa {
+        std::shared_mutex trava;
+        ArenaNos<BSTNode<T>> arena;
+    };
+
+    BST<T>** tabela;
+    size_t SIZE;
+    size_t numFaixas;
+    Faixa* faixas;
+    HashPolicy politica;
+    std::atomic<size_t> numItens{0};
+
+    template <typename K>
+    size_t Hash(const K& item) const { return politica(visaoChave(item), SIZE); }
+    Faixa& faixaDe(size_t indice) { return faixas[indice % numFaixas]; }
+
+public:
+    // 4 faixas por nucleo arredondado pra potencia de 2, entre 64 e 256
+    // (ou uma por gaveta, se a tabela tiver menos gavetas que isso)
+    static size_t faixasPadrao(size_t gavetas) {
+        size_t nucleos = std::max(1u, std::thread::hardware_concurrency());
+        size_t n = 64;
+        while (n < 4 * nucleos && n < 256) n *= 2;
+        return std::min(n, gavetas);
+    }
+
+    // faixas = 0: faixasPadrao
+    explicit HashTableConcorrente(size_t gavetas = 151, size_t faixas = 0) : SIZE(gavetas) {
+        numFaixas = faixas == 0 ? faixasPadrao(gavetas) : std::min(faixas, gavetas);
+        this->faixas = new Faixa[numFaixas];
+        tabela = new BST<T>*[SIZE];
+        for (size_t i = 0; i < SIZE; i++) {
+            tabela[i] = nullptr;
+        }
+    }
+    ~HashTableConcorrente() {
+        for (size_t i = 0; i < SIZE; i++) {
+            if (tabela[i] != nullptr) {
+                tabela[i]->Abandonar(); // as arenas das faixas soltam tudo
+                delete tabela[i];
+            }
+        }
+        delete[] tabela;
+        delete[] faixas;
+    }
+    HashTableConcorrente(const HashTableConcorrente&) = delete;
+    HashTableConcorrente& operator=(const HashTableConcorrente&) = delete;
+
+    template <typename K>
+    void insert(const K& chave) {
+        std::string_view item = visaoChave(chave);
+        size_t indice = Hash(item);
+        Faixa& faixa = faixaDe(indice);
+        std::unique_lock<std::shared_mutex> trava(faixa.trava);
+        BST<T>*& arvore = tabela[indice];
+        if (arvore == nullptr) {
+            arvore = new BST<T>(&faixa.arena);
+        }
+        int antes = arvore->size();
+        arvore->Insert(item);
+        numItens.fetch_add(arvore->size() - antes, std::memory_order_relaxed);
+    }
+
+    void remove(const T& item) {
+        size_t indice = Hash(item);
+        std::unique_lock<std::shared_mutex> trava(faixaDe(indice).trava);
+        BST<T>* arvore = tabela[indice];
+        if (arvore == nullptr) {
+            return;
+        }
+        int antes = arvore->size();
+        arvore->Remove(item);
+        numItens.fetch_sub(antes - arvore->size(), std::memory_order_relaxed);
+    }
+
+    template <typename K>
+    bool search(const K& chave) {
+        std::string_view item = visaoChave(chave);
+        size_t indice = Hash(item);
+        std::shared_lock<std::shared_mutex> trava(faixaDe(indice).trava);
+        BST<T>* arvore = tabela[indice];
+        return arvore != nullptr && arvore->Search(item) != nullptr;
+    }
+
+    // igual ao buscarMostrarAltura, mas sem imprimir o DOT (altura da arvore ou -1)
+    template <typename K>
+    int buscarAltura(const K& chave) {
+        std::string_view item = visaoChave(chave);
+        size_t indice = Hash(item);
+        std::shared_lock<std::shared_mutex> trava(faixaDe(indice).trava);
+        BST<T>* arvore = tabela[indice];
+        if (arvore == nullptr || arvore->Search(item) == nullptr) {
+            return -1;
+        }
+        return arvore->getRoot()->getHeight();
+    }
+
+    int length() const { return static_cast<int>(numItens.load(std::memory_order_relaxed)); }
+    bool empty() const { return length() == 0; }
+    size_t faixasUsadas() const { return numFaixas; }
+
+    // memoria dos nos (blocos das arenas das faixas); so com a tabela parada
+    size_t bytesReservados() const {
+        size_t total = 0;
+        for (size_t f = 0; f < numFaixas; f++) total += faixas[f].arena.bytesReservados();
+        return total;
+    }
+
+    // confere todas as arvores (trava uma faixa de cada vez)
+    bool conferirArvores() {
+        for (size_t i = 0; i < SIZE; i++) {
+            std::shared_lock<std::shared_mutex> trava(faixaDe(i).trava);
+            if (tabela[i] != nullptr && !tabela[i]->ConferirAVL()) return false;
+        }
+        return true;
+    }
+};
+
+// RECLAMACAO POR EPOCAS (estilo RCU)
+// Leitor: anota a epoca global no slot da thread (store simples + fence), le a arvore
+// e zera o slot na saida. Nenhuma operacao atomica de leitura-modificacao-escrita.
+// Escritor: depois de publicar a raiz nova, aposenta os nos velhos com a epoca atual;
+// de tempos em tempos avanca a epoca e apaga o que foi aposentado antes da menor
+// epoca anotada pelos leitores ativos (ninguem mais consegue estar olhando pra eles).
+class DominioEpocas {
+private:
+    static constexpr size_t MAX_LEITORES = 256;
+    static constexpr size_t COLETAR_A_CADA = 64;
+
+    struct alignas(64) SlotLeitor {
+        std::atomic<uint64_t> epoca{0}; // 0 = fora de leitura
+        std::atomic<bool> ocupado{false};
+    };
+
+    struct Aposentado {
+        void* ponteiro;
+        void (*apagar)(void*);
+        uint64_t epoca;
+    };
+
+    std::atomic<uint64_t> epocaGlobal{1};
+    SlotLeitor slots[MAX_LEITORES];
+    std::mutex travaLixo;
+    vector<Aposentado> lixo;
+    size_t desdeColeta = 0;
+
+    // slot da thread: pego uma vez e devolvido quando a thread acaba
+    struct RegistroThread {
+        SlotLeitor* slot = nullptr;
+        ~RegistroThread() {
+            if (slot != nullptr) slot->ocupado.store(false, std::memory_order_release);
+        }
+    };
+
+    SlotLeitor& slotDaThread() {
+        thread_local RegistroThread registro;
+        if (registro.slot == nullptr) {
+            for (;;) {
+                for (auto& s : slots) {
+                    bool livre = false;
+                    if (s.ocupado.compare_exchange_strong(livre, true)) {
+                        registro.slot = &s;
+                        return s;
+                    }
+                }
+                std::this_thread::yield(); // mais de MAX_LEITORES threads ao mesmo tempo
+            }
+        }
+        return *registro.slot;
+    }
+
+    // com a travaLixo pega
+    void coletar() {
+        desdeColeta = 0;
+        epocaGlobal.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint64_t minima = ~uint64_t(0);
+        for (auto& s : slots) {
+            uint64_t e = s.epoca.load(std::memory_order_acquire);
+            if (e != 0 && e < minima) minima = e;
+        }
+        size_t ficam = 0;
+        for (auto& a : lixo) {
+            if (a.epoca < minima) {
+                a.apagar(a.ponteiro);
+            } else {
+                lixo[ficam++] = a;
+            }
+        }
+        lixo.resize(ficam);
+    }
+
+public:
+    static DominioEpocas& global() {
+        static DominioEpocas dominio;
+        return dominio;
+    }
+    ~DominioEpocas() {
+        for (auto& a : lixo) a.apagar(a.ponteiro);
+    }
+
+    void entrar() {
+        SlotLeitor& s = slotDaThread();
+        s.epoca.store(epocaGlobal.load(std::memory_order_acquire), std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+    void sair() {
+        slotDaThread().epoca.store(0, std::memory_order_release);
+    }
+
+    // so chamar depois que o objeto ja nao e alcancavel pela raiz publicada
+    template <typename X>
+    void aposentar(const X* objeto) {
+        std::lock_guard<std::mutex> trava(travaLixo);
+        lixo.push_back({const_cast<X*>(objeto), [](void* p) { delete static_cast<X*>(p); },
+                        epocaGlobal.load(std::memory_order_acquire)});
+        if (++desdeColeta >= COLETAR_A_CADA) {
+            coletar();
+        }
+    }
+};
+
+// trecho de leitura: enquanto existir, nada que a thread ve e apagado
+class LeituraRCU {
+public:
+    LeituraRCU() { DominioEpocas::global().entrar(); }
+    ~LeituraRCU() { DominioEpocas::global().sair(); }
+    LeituraRCU(const LeituraRCU&) = delete;
+    LeituraRCU& operator=(const LeituraRCU&) = delete;
+};
+
+// No imutavel: depois de publicado nunca muda. O item fica separado e e compartilhado
+// por todas as copias do no (copiar o caminho nao copia a string); ele so e aposentado
+// quando a chave sai da arvore.
+template <typename T>
+struct NoRCU {
+    const T* item;
+    const NoRCU* esq;
+    const NoRCU* dir;
+    int altura;
+};
+
+// AVL persistente (copia de caminho) pra um gaveta so.
+// Search nao trava nada; Insert/Remove sao serializados pela trava de escrita,
+// montam um caminho novo (rotacoes tambem criam nos novos) e publicam a raiz.
+template <typename T>
+class ArvoreRCU {
+private:
+    std::atomic<const NoRCU<T>*> raiz{nullptr};
+    std::mutex escrita;
+    int numNos = 0;
+    vector<const NoRCU<T>*> trocados; // nos da versao velha que sairam nessa operacao
+
+    static int altura(const NoRCU<T>* no) { return no == nullptr ? 0 : no->altura; }
+
+    static const NoRCU<T>* criar(const T* item, const NoRCU<T>* esq, const NoRCU<T>* dir) {
+        return new NoRCU<T>{item, esq, dir, 1 + max(altura(esq), altura(dir))};
+    }
+
+    // monta (item, esq, dir) ja balanceado; filhos que giram sao copiados, nunca alterados
+    const NoRCU<T>* balancear(const T* item, const NoRCU<T>* esq, const NoRCU<T>* dir) {
+        int fb = altura(dir) - altura(esq);
+        if (fb < -1) {
+            if (altura(esq->esq) >= altura(esq->dir)) {
+                trocados.push_back(esq);
+                return criar(esq->item, esq->esq, criar(item, esq->dir, dir));
+            }
+            const NoRCU<T>* meio = esq->dir;
+            trocados.push_back(esq);
+            trocados.push_back(meio);
+            return criar(meio->item, criar(esq->item, esq->esq, meio->esq), criar(item, meio->dir, dir));
+        }
+        if (fb > 1) {
+            if (altura(dir->dir) >= altura(dir->esq)) {
+                trocados.push_back(dir);
+                return criar(dir->item, criar(item, esq, dir->esq), dir->dir);
+            }
+            const NoRCU<T>* meio = dir->esq;
+            trocados.push_back(dir);
+            trocados.push_back(meio);
+            return criar(meio->item, criar(item, esq, meio->esq), criar(dir->item, meio->dir, dir->dir));
+        }
+        return criar(item, esq, dir);
+    }
+
+    // devolve o proprio no quando nada mudou embaixo dele
+    const NoRCU<T>* inserir(const NoRCU<T>* no, std::string_view chave) {
+        if (no == nullptr) {
+            numNos++;
+            return criar(new T(chave), nullptr, nullptr);
+        }
+        int cmp = comparar(chave, *no->item);
+        if (cmp == 0) return no;
+        const NoRCU<T>* filho = cmp < 0 ? no->esq : no->dir;
+        const NoRCU<T>* novo = inserir(filho, chave);
+        if (novo == filho) return no;
+        trocados.push_back(no);
+        return cmp < 0 ? balancear(no->item, novo, no->dir) : balancear(no->item, no->esq, novo);
+    }
+
+    const NoRCU<T>* removerMinimo(const NoRCU<T>* no) {
+        trocados.push_back(no);
+        if (no->esq == nullptr) return no->dir;
+        return balancear(no->item, removerMinimo(no->esq), no->dir);
+    }
+
+    const NoRCU<T>* remover(const NoRCU<T>* no, std::string_view chave, const T*& removido) {
+        if (no == nullptr) return nullptr;
+        int cmp = comparar(chave, *no->item);
+        if (cmp != 0) {
+            const NoRCU<T>* filho = cmp < 0 ? no->esq : no->dir;
+            const NoRCU<T>* novo = remover(filho, chave, removido);
+            if (novo == filho) return no;
+            trocados.push_back(no);
+            return cmp < 0 ? balancear(no->item, novo, no->dir) : balancear(no->item, no->esq, novo);
+        }
+        numNos--;
+        removido = no->item;
+        trocados.push_back(no);
+        if (no->esq == nullptr) return no->dir;
+        if (no->dir == nullptr) return no->esq;
+        const NoRCU<T>* sucessor = no->dir;
+        while (sucessor->esq != nullptr) sucessor = sucessor->esq;
+        return balancear(sucessor->item, no->esq, removerMinimo(no->dir));
+    }
+
+    void publicar(const NoRCU<T>* novaRaiz) {
+        raiz.store(novaRaiz, std::memory_order_release);
+        for (const NoRCU<T>* velho : trocados) {
+            DominioEpocas::global().aposentar(velho);
+        }
+        trocados.clear();
+    }
+
+    static void destruir(const NoRCU<T>* no) {
+        if (no == nullptr) return;
+        destruir(no->esq);
+        destruir(no->dir);
+        delete no->item;
+        delete no;
+    }
+
+    static int conferir(const NoRCU<T>* no, bool& ok) {
+        if (no == nullptr) return 0;
+        if (no->esq != nullptr && comparar(*no->esq->item, *no->item) >= 0) ok = false;
+        if (no->dir != nullptr && comparar(*no->dir->item, *no->item) <= 0) ok = false;
+        int he = conferir(no->esq, ok);
+        int hd = conferir(no->dir, ok);
+        if (no->altura != 1 + max(he, hd) || he - hd > 1 || hd - he > 1) ok = false;
+        return no->altura;
+    }
+
+public:
+    ArvoreRCU() = default;
+    ~ArvoreRCU() { destruir(raiz.load(std::memory_order_relaxed)); } // sem leitores nessa hora
+    ArvoreRCU(const ArvoreRCU&) = delete;
+    ArvoreRCU& operator=(const ArvoreRCU&) = delete;
+
+    // tem que estar dentro de um LeituraRCU; devolve o item (ou nullptr)
+    const NoRCU<T>* Search(std::string_view chave) const {
+        const NoRCU<T>* no = raiz.load(std::memory_order_acquire);
+        while (no != nullptr) {
+            int cmp = comparar(chave, *no->item);
+            if (cmp == 0) return no;
+            no = cmp < 0 ? no->esq : no->dir;
+        }
+        return nullptr;
+    }
+    int alturaRaiz() const { return altura(raiz.load(std::memory_order_acquire)); }
+
+    // devolve 1 se inseriu
+    int Insert(std::string_view chave) {
+        std::lock_guard<std::mutex> trava(escrita);
+        const NoRCU<T>* velha = raiz.load(std::memory_order_relaxed);
+        const NoRCU<T>* nova = inserir(velha, chave);
+        if (nova == velha) return 0;
+        publicar(nova);
+        return 1;
+    }
+
+    // devolve 1 se removeu
+    int Remove(std::string_view chave) {
+        std::lock_guard<std::mutex> trava(escrita);
+        const NoRCU<T>* velha = raiz.load(std::memory_order_relaxed);
+        const T* removido = nullptr;
+        const NoRCU<T>* nova = remover(velha, chave, removido);
+        if (removido == nullptr) return 0;
+        publicar(nova);
+        DominioEpocas::global().aposentar(removido);
+        return 1;
+    }
+
+    bool ConferirAVL() {
+        std::lock_guard<std::mutex> trava(escrita);
+        bool ok = true;
+        conferir(raiz.load(std::memory_order_relaxed), ok);
+        return ok;
+    }
+};
+
+// Tabela pra leitura pesada: gavetas ArvoreRCU, busca sem trava nenhuma e sem RMW.
+// Escritores so esperam outros escritores da mesma gaveta. Tamanho fixo.
+template <typename T, typename HashPolicy = HashLegado>
+class HashTableRCU {
+private:
+    struct alignas(64) Gaveta {
+        ArvoreRCU<T> arvore;
+    };
+
+    Gaveta* tabela;
+    size_t SIZE;
+    HashPolicy politica;
+    std::atomic<size_t> numItens{0};
+
+    size_t Hash(std::string_view item) const { return politica(item, SIZE); }
+
+public:
+    explicit HashTableRCU(size_t gavetas = 151) : SIZE(gavetas) {
+        tabela = new Gaveta[SIZE];
+    }
+    ~HashTableRCU() { delete[] tabela; }
+    HashTableRCU(const HashTableRCU&) = delete;
+    HashTableRCU& operator=(const HashTableRCU&) = delete;
+
+    template <typename K>
+    void insert(const K& chave) {
+        std::string_view item = visaoChave(chave);
+        numItens.fetch_add(tabela[Hash(item)].arvore.Insert(item), std::memory_order_relaxed);
+    }
+
+    template <typename K>
+    void remove(const K& chave) {
+        std::string_view item = visaoChave(chave);
+        numItens.fetch_sub(tabela[Hash(item)].arvore.Remove(item), std::memory_order_relaxed);
+    }
+
+    template <typename K>
+    bool search(const K& chave) const {
+        std::string_view item = visaoChave(chave);
+        LeituraRCU leitura;
+        return tabela[Hash(item)].arvore.Search(item) != nullptr;
+    }
+
+    template <typename K>
+    int buscarAltura(const K& chave) const {
+        std::string_view item = visaoChave(chave);
+        LeituraRCU leitura;
+        const ArvoreRCU<T>& arvore = tabela[Hash(item)].arvore;
+        return arvore.Search(item) != nullptr ? arvore.alturaRaiz() : -1;
+    }
+
+    int length() const { return static_cast<int>(numItens.load(std::memory_order_relaxed)); }
+    bool empty() const { return length() == 0; }
+
+    bool conferirArvores() {
+        for (size_t i = 0; i < SIZE; i++) {
+            if (!tabela[i].arvore.ConferirAVL()) return false;
+        }
+        return true;
+    }
+};
+
+// FUNCOES AUXILIARES AQUI
+// mesmos criterios do >> e do ispunct no locale "C", sem consultar locale
+inline bool ehEspaco(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+inline bool ehPontuacao(char c) {
+    return (c >= '!' && c <= '/') || (c >= ':' && c <= '@') || (c >= '[' && c <= '`') || (c >= '{' && c <= '~');
+}
+
+string limpador(const string& palavra) {
+    string cleaned;
+    cleaned.reserve(palavra.size());
+    for (char c: palavra) {
+        if (!ehPontuacao(c)) cleaned += c;
+    }
+
+    // palavra so de pontuacao vira "" (antes caia no fim da funcao sem return)
+    return cleaned;
+}
+
+// ARQUIVO MAPEADO NA MEMORIA
+// mmap do arquivo inteiro (so leitura); sem mmap le tudo pra um buffer
+class ArquivoMapeado {
+private:
+    const char* dados = nullptr;
+    size_t tamanho = 0;
+#ifdef TEM_MMAP
+    void* mapa = nullptr;
+#else
+    std::string buffer;
+#endif
+
+public:
+    // sequencial: vai ler do comeco ao fim (texto); senao e acesso aleatorio (snapshot)
+    explicit ArquivoMapeado(const string& caminho, bool sequencial = true) {
+#ifdef TEM_MMAP
+        int fd = open(caminho.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* m = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (m != MAP_FAILED) {
+                mapa = m;
+                dados = static_cast<const char*>(m);
+                tamanho = info.st_size;
+                madvise(m, tamanho, sequencial ? MADV_SEQUENTIAL : MADV_RANDOM);
+            }
+        }
+        close(fd);
+#else
+        (void)sequencial;
+        ifstream in(caminho, ios::binary);
+        buffer.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+        dados = buffer.data();
+        tamanho = buffer.size();
+#endif
+    }
+    ~ArquivoMapeado() {
+#ifdef TEM_MMAP
+        if (mapa != nullptr) {
+            munmap(mapa, tamanho);
+        }
+#endif
+    }
+    ArquivoMapeado(const ArquivoMapeado&) = delete;
+    ArquivoMapeado& operator=(const ArquivoMapeado&) = delete;
+
+    const char* data() const { return dados; }
+    size_t size() const { return tamanho; }
+    std::string_view conteudo() const { return std::string_view(dados, tamanho); }
+};
+
+// SNAPSHOT BINARIO
+// Arquivo: cabecalho | gavetas | nos | texto, tudo alinhado em 8. Nao tem ponteiro:
+// filho e indice no vetor de nos e chave e deslocamento no texto, entao o arquivo
+// mapeado ja e a estrutura (SnapshotTabela busca direto nele, sem montar nada).
+// Cada gaveta tem os nos da sua arvore em pre-ordem (raiz primeiro), com a forma e as
+// alturas da tabela que salvou: as consultas dao as mesmas alturas e o mesmo DOT.
+// O checksum cobre o cabecalho (tirando o proprio campo) e o resto do arquivo.
+// Os inteiros ficam na ordem de bytes da maquina (marcaEndian confere).
+const char MAGICA_SNAPSHOT[8] = {'P', 'P', '3', 'S', 'N', 'A', 'P', '\0'};
+const uint32_t VERSAO_SNAPSHOT = 1;
+const uint32_t NENHUM_NO = 0xffffffffu;
+
+struct CabecalhoSnapshot {
+    char magica[8];
+    uint32_t versao;
+    uint32_t marcaEndian; // 0x01020304 como a maquina que salvou escreve
+    char politica[16];    // HashPolicy::nome
+    uint64_t gavetas;
+    uint64_t numNos;
+    uint64_t tamTexto;    // ja com o preenchimento ate multiplo de 8
+    uint64_t checksum;    // por ultimo: o checksum pega tudo antes dele
+};
+
+struct GavetaSnapshot {
+    uint32_t primeiro; // indice da raiz (os nos da arvore vem todos em seguida)
+    uint32_t numNos;
+};
+
+struct NoSnapshot {
+    uint64_t prefixo;   // prefixo64 da chave: quase toda comparacao para aqui
+    uint32_t texto;     // deslocamento da chave no texto
+    uint32_t tamanho;
+    uint32_t esq;       // indices globais dos filhos (NENHUM_NO = nao tem)
+    uint32_t dir;
+    int32_t altura;
+    uint32_t subarvore; // tamanho da subarvore
+};
+
+static_assert(sizeof(CabecalhoSnapshot) == 64, "cabecalho do snapshot mudou de tamanho");
+static_assert(sizeof(GavetaSnapshot) == 8 && sizeof(NoSnapshot) == 32, "layout do snapshot mudou");
+
+// n multiplo de 8; da pra ir passando o h de um pedaco pro outro
+inline uint64_t checksumSnapshot(uint64_t h, const char* p, size_t n) {
+    const uint64_t primo = 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i < n; i += 8) {
+        h = misturar64(h ^ lerPalavra64(p + i), primo);
+    }
+    return h;
+}
+
+// onde fica cada parte, conferido contra o tamanho do arquivo
+struct PartesSnapshot {
+    const CabecalhoSnapshot* cabecalho = nullptr;
+    const GavetaSnapshot* gavetas = nullptr;
+    const NoSnapshot* nos = nullptr;
+    const char* texto = nullptr;
+};
+
+// nullptr = ok, senao o motivo. Sem 'tudo' so confere cabecalho e tamanhos (O(1));
+// com 'tudo' tambem o checksum e a forma de cada gaveta (O(arquivo)): tem que ser
+// exatamente o que o save grava, senao quem monta ou libera a arvore se perde.
+inline const char* conferirSnapshot(const char* dados, size_t tamanho, const char* politica, bool tudo,
+                                    PartesSnapshot& partes) {
+    if (dados == nullptr || tamanho < sizeof(CabecalhoSnapshot)) return "arquivo curto demais";
+    if (reinterpret_cast<uintptr_t>(dados) % 8 != 0) return "arquivo desalinhado na memoria";
+    const CabecalhoSnapshot* cab = reinterpret_cast<const CabecalhoSnapshot*>(dados);
+    if (memcmp(cab->magica, MAGICA_SNAPSHOT, sizeof(MAGICA_SNAPSHOT)) != 0) return "nao e snapshot";
+    if (cab->versao != VERSAO_SNAPSHOT) return "versao diferente";
+    if (cab->marcaEndian != 0x01020304u) return "ordem de bytes diferente";
+    if (strncmp(cab->politica, politica, sizeof(cab->politica)) != 0) return "politica de hash diferente";
+    size_t resto = tamanho - sizeof(CabecalhoSnapshot);
+    if (cab->gavetas == 0 || cab->gavetas > resto / sizeof(GavetaSnapshot)) return "tamanho errado";
+    resto -= cab->gavetas * sizeof(GavetaSnapshot);
+    if (cab->numNos > resto / sizeof(NoSnapshot) || cab->numNos >= NENHUM_NO) return "tamanho errado";
+    resto -= cab->numNos * sizeof(NoSnapshot);
+    if (cab->tamTexto != resto || cab->tamTexto % 8 != 0) return "tamanho errado";
+
+    partes.cabecalho = cab;
+    partes.gavetas = reinterpret_cast<const GavetaSnapshot*>(dados + sizeof(CabecalhoSnapshot));
+    partes.nos = reinterpret_cast<const NoSnapshot*>(partes.gavetas + cab->gavetas);
+    partes.texto = reinterpret_cast<const char*>(partes.nos + cab->numNos);
+    if (!tudo) return nullptr;
+
+    uint64_t h = checksumSnapshot(0, dados, offsetof(CabecalhoSnapshot, checksum));
+    h = checksumSnapshot(h, dados + sizeof(CabecalhoSnapshot), tamanho - sizeof(CabecalhoSnapshot));
+    if (h != cab->checksum) return "checksum nao bate";
+
+    // Pre-ordem estrita: esq = k+1 e dir = k+1+subarvore(esq), com subarvore e altura
+    // batendo com os filhos, AVL e chaves crescendo em ordem. Assim cada no tem um pai
+    // so e a raiz cobre a gaveta inteira. De tras pra frente: quando chega no pai os
+    // filhos ja foram conferidos. menor/maior = no da menor/maior chave da subarvore.
+    auto chaveDo = [&](uint64_t k) {
+        return std::string_view(partes.texto + partes.nos[k].texto, partes.nos[k].tamanho);
+    };
+    vector<uint32_t> menor(cab->numNos), maior(cab->numNos);
+    uint64_t contados = 0;
+    for (uint64_t i = 0; i < cab->gavetas; i++) {
+        const GavetaSnapshot& g = partes.gavetas[i];
+        uint64_t fim = static_cast<uint64_t>(g.primeiro) + g.numNos;
+        if (g.numNos == 0) continue;
+        if (fim > cab->numNos) return "gaveta aponta pra fora";
+        for (uint64_t k = fim; k-- > g.primeiro;) {
+            const NoSnapshot& no = partes.nos[k];
+            if (static_cast<uint64_t>(no.texto) + no.tamanho > cab->tamTexto) return "chave aponta pra fora";
+            std::string_view chave = chaveDo(k);
+            if (no.prefixo != prefixo64(chave)) return "prefixo nao bate com a chave";
+            uint64_t tamEsq = 0;
+            uint64_t tamDir = 0;
+            int altEsq = 0;
+            int altDir = 0;
+            menor[k] = maior[k] = static_cast<uint32_t>(k);
+            if (no.esq != NENHUM_NO) {
+                if (no.esq != k + 1 || no.esq >= fim) return "forma fora da pre-ordem";
+                if (chaveDo(maior[no.esq]).compare(chave) >= 0) return "chaves fora de ordem";
+                tamEsq = partes.nos[no.esq].subarvore;
+                altEsq = partes.nos[no.esq].altura;
+                menor[k] = menor[no.esq];
+            }
+            if (no.dir != NENHUM_NO) {
+                if (no.dir != k + 1 + tamEsq || no.dir >= fim) return "forma fora da pre-ordem";
+                if (chaveDo(menor[no.dir]).compare(chave) <= 0) return "chaves fora de ordem";
+                tamDir = partes.nos[no.dir].subarvore;
+                altDir = partes.nos[no.dir].altura;
+                maior[k] = maior[no.dir];
+            }
+            if (no.subarvore != 1 + tamEsq + tamDir) return "tamanho de subarvore errado";
+            if (no.altura != 1 + max(altEsq, altDir)) return "altura errada";
+            if (altDir - altEsq < -1 || altDir - altEsq > 1) return "arvore desbalanceada";
+        }
+        if (partes.nos[g.primeiro].subarvore != g.numNos) return "no sem pai na gaveta";
+        contados += g.numNos;
+    }
+    if (contados != cab->numNos) return "nos sobrando";
+    return nullptr;
+}
+
+// grava em caminho.tmp, fsync e rename: quem abrir o arquivo nunca ve ele pela metade
+inline bool gravarAtomico(const string& caminho, std::initializer_list<std::string_view> partes) {
+    string temp = caminho + ".tmp";
+    bool ok = true;
+#ifdef TEM_MMAP
+    int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    for (std::string_view parte : partes) {
+        const char* p = parte.data();
+        size_t n = parte.size();
+        while (ok && n > 0) {
+            ssize_t escritos = write(fd, p, n);
+            if (escritos < 0 && errno == EINTR) continue;
+            if (escritos <= 0) {
+                ok = false;
+                break;
+            }
+            p += escritos;
+            n -= escritos;
+        }
+    }
+    ok = ok && fsync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+#else
+    {
+        ofstream out(temp, ios::binary | ios::trunc);
+        for (std::string_view parte : partes) {
+            out.write(parte.data(), parte.size());
+        }
+        ok = static_cast<bool>(out);
+    }
+#endif
+    if (!ok || std::rename(temp.c_str(), caminho.c_str()) != 0) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// A tabela direto do arquivo mapeado, so leitura: abrir e mmap + conferir o cabecalho
+// (e, se pedir, checksum e indices). Nenhum no e montado: a busca desce nos
+// NoSnapshot do proprio arquivo. Serve no lugar da HashTable no testarAlturas.
+template <typename HashPolicy = HashLegado>
+class SnapshotTabela {
+private:
+    ArquivoMapeado arquivo;
+    PartesSnapshot partes;
+    const char* problema;
+    HashPolicy politica;
+
+    std::string_view chaveDo(const NoSnapshot& no) const {
+        return std::string_view(partes.texto + no.texto, no.tamanho);
+    }
+    const GavetaSnapshot& gavetaDe(std::string_view chave) const {
+        return partes.gavetas[politica(chave, partes.cabecalho->gavetas)];
+    }
+    // indice do no com a chave (ou NENHUM_NO)
+    uint32_t procurar(std::string_view chave) const {
+        const GavetaSnapshot& g = gavetaDe(chave);
+        uint64_t prefixo = prefixo64(chave);
+        uint32_t i = g.numNos > 0 ? g.primeiro : NENHUM_NO;
+        while (i != NENHUM_NO) {
+            const NoSnapshot& no = partes.nos[i];
+            int cmp;
+            if (prefixo != no.prefixo) cmp = prefixo < no.prefixo ? -1 : 1;
+            else if (chave.size() <= 8 || no.tamanho <= 8) cmp = comparar(chave.size(), static_cast<size_t>(no.tamanho));
+            else cmp = chave.compare(chaveDo(no));
+            if (cmp == 0) return i;
+            i = cmp < 0 ? no.esq : no.dir;
+        }
+        return NENHUM_NO;
+    }
+    // mesmo DOT do BST::generateDot (inclusive so descer quando tem filho direito), sem
+    // recursao: pilha de indices, o direito entra antes pra sair depois do esquerdo
+    void desenharArvore(uint32_t raiz) const {
+        vector<uint32_t> pilha(1, raiz);
+        while (!pilha.empty()) {
+            const NoSnapshot& no = partes.nos[pilha.back()];
+            pilha.pop_back();
+            std::string_view item = chaveDo(no);
+            cout << "    " << item << " [label=\"" << item << "\\nAltura: " << no.altura << "\"];\n";
+            if (no.esq != NENHUM_NO) {
+                cout << "    " << item << " -> " << chaveDo(partes.nos[no.esq]) << ";\n";
+            }
+            if (no.dir != NENHUM_NO) {
+                cout << "    " << item << " -> " << chaveDo(partes.nos[no.dir]) << ";\n";
+                pilha.push_back(no.dir);
+                if (no.esq != NENHUM_NO) pilha.push_back(no.esq);
+            }
+        }
+    }
+
+public:
+    explicit SnapshotTabela(const string& caminho, bool conferirTudo = true) : arquivo(caminho, false) {
+        problema = conferirSnapshot(arquivo.data(), arquivo.size(), HashPolicy::nome, conferirTudo, partes);
+    }
+    // arquivo recusado: as partes podem nem ter sido achadas, entao tudo responde vazio
+    bool valido() const { return problema == nullptr; }
+    const char* erro() const { return problema; }
+    size_t gavetas() const { return valido() ? partes.cabecalho->gavetas : 0; }
+    int length() const { return valido() ? static_cast<int>(partes.cabecalho->numNos) : 0; }
+    size_t bytes() const { return arquivo.size(); }
+
+    template <typename K>
+    bool search(const K& chave) const {
+        return valido() && procurar(visaoChave(chave)) != NENHUM_NO;
+    }
+    // igual o da HashTable: achou -> imprime o DOT da arvore e devolve a altura dela
+    template <typename K>
+    int buscarMostrarAltura(const K& key) const {
+        std::string_view chave = visaoChave(key);
+        if (!valido() || procurar(chave) == NENHUM_NO) {
+            return -1;
+        }
+        const GavetaSnapshot& g = gavetaDe(chave);
+        cout << "CODIGO DOT DE: " << chave << endl;
+        cout << "digraph G {\n";
+        desenharArvore(g.primeiro);
+        cout << "}\n";
+        cout << endl;
+        return partes.nos[g.primeiro].altura;
+    }
+};
+
+template <typename T, typename HashPolicy, typename Balde>
+bool HashTable<T, HashPolicy, Balde>::save(const string& caminho) {
+    static_assert(std::is_same<Balde, BST<T>>::value, "snapshot precisa da forma da arvore: so gaveta BST");
+    static_assert(!ehEntradaMapa<T>::value, "snapshot so guarda as chaves: o modo mapa perderia os valores");
+    while (antiga != nullptr) {
+        migrarPasso();
+    }
+    vector<GavetaSnapshot> gav(SIZE);
+    vector<NoSnapshot> nos;
+    nos.reserve(numItens);
+    string texto;
+    for (size_t i = 0; i < SIZE; i++) {
+        gav[i] = {static_cast<uint32_t>(nos.size()), 0};
+        if (tabela[i] == nullptr) continue;
+        // pre-ordem: o filho esquerdo e o proximo, o direito vem depois da subarvore esquerda
+        tabela[i]->EmPreOrdem([&](const BSTNode<T>& no) {
+            uint32_t k = static_cast<uint32_t>(nos.size());
+            std::string_view chave = visaoChave(no.getItem());
+            BSTNode<T>* esq = no.getLeft();
+            NoSnapshot d;
+            d.prefixo = prefixo64(chave);
+            d.texto = static_cast<uint32_t>(texto.size());
+            d.tamanho = static_cast<uint32_t>(chave.size());
+            d.esq = esq != nullptr ? k + 1 : NENHUM_NO;
+            d.dir = no.getRight() != nullptr ? k + 1 + (esq != nullptr ? esq->getTamanho() : 0) : NENHUM_NO;
+            d.altura = no.getHeight();
+            d.subarvore = static_cast<uint32_t>(no.getTamanho());
+            texto.append(chave);
+            nos.push_back(d);
+        });
+        gav[i].numNos = static_cast<uint32_t>(nos.size() - gav[i].primeiro);
+    }
+    if (texto.size() > NENHUM_NO || nos.size() >= NENHUM_NO) {
+        return false; // indice de 32 bits nao da conta
+    }
+    texto.resize((texto.size() + 7) / 8 * 8, '\0');
+
+    CabecalhoSnapshot cab;
+    memset(&cab, 0, sizeof(cab));
+    memcpy(cab.magica, MAGICA_SNAPSHOT, sizeof(MAGICA_SNAPSHOT));
+    cab.versao = VERSAO_SNAPSHOT;
+    cab.marcaEndian = 0x01020304u;
+    strncpy(cab.politica, HashPolicy::nome, sizeof(cab.politica) - 1);
+    cab.gavetas = SIZE;
+    cab.numNos = nos.size();
+    cab.tamTexto = texto.size();
+    std::string_view partes[] = {
+        std::string_view(reinterpret_cast<const char*>(gav.data()), gav.size() * sizeof(GavetaSnapshot)),
+        std::string_view(reinterpret_cast<const char*>(nos.data()), nos.size() * sizeof(NoSnapshot)),
+        std::string_view(texto),
+    };
+    uint64_t h = checksumSnapshot(0, reinterpret_cast<const char*>(&cab), offsetof(CabecalhoSnapshot, checksum));
+    for (std::string_view parte : partes) {
+        h = checksumSnapshot(h, parte.data(), parte.size());
+    }
+    cab.checksum = h;
+    return gravarAtomico(caminho, {std::string_view(reinterpret_cast<const char*>(&cab), sizeof(cab)),
+                                   partes[0], partes[1], partes[2]});
+}
+
+template <typename T, typename HashPolicy, typename Balde>
+bool HashTable<T, HashPolicy, Balde>::load(const string& caminho) {
+    static_assert(std::is_same<Balde, BST<T>>::value, "snapshot precisa da forma da arvore: so gaveta BST");
+    static_assert(!ehEntradaMapa<T>::value, "snapshot so guarda as chaves: o modo mapa perderia os valores");
+    ArquivoMapeado arquivo(caminho);
+    PartesSnapshot partes;
+    if (conferirSnapshot(arquivo.data(), arquivo.size(), HashPolicy::nome, true, partes) != nullptr) {
+        return false;
+    }
+    limparTudo(partes.cabecalho->gavetas);
+    for (size_t i = 0; i < SIZE; i++) {
+        const GavetaSnapshot& g = partes.gavetas[i];
+        if (g.numNos == 0) continue;
+        const NoSnapshot* nos = partes.nos + g.primeiro;
+        // os indices do arquivo sao globais; a arvore quer contando da raiz dela
+        auto local = [&](uint32_t k) { return k == NENHUM_NO ? -1 : static_cast<int>(k - g.primeiro); };
+        tabela[i] = new Balde(&arena);
+        tabela[i]->CarregarForma(
+            static_cast<int>(g.numNos),
+            [&](int k) { return std::string_view(partes.texto + nos[k].texto, nos[k].tamanho); },
+            [&](int k) { return std::make_pair(local(nos[k].esq), local(nos[k].dir)); });
+        numItens += g.numNos;
+    }
+    SO_ESTATISTICA(publicarGavetas();)
+    return true;
+}
+
+// TOKENIZADOR VETORIZADO
+// Classifica o texto em blocos de 64 bytes: um bit por byte dizendo se e espaco e outro
+// se e pontuacao (ASCII, igual ao ispunct/isspace no locale "C"; byte >= 0x80 nao e nenhum).
+// Tem versao SSE2 (4x16), AVX2 (2x32) e escalar; qual usar e decidido em tempo de execucao.
+typedef void (*ClassificadorBloco)(const char* p, uint64_t& espacos, uint64_t& pontuacao);
+
+inline void classificarEscalar(const char* p, uint64_t& espacos, uint64_t& pontuacao) {
+    uint64_t e = 0;
+    uint64_t pt = 0;
+    for (int i = 0; i < 64; i++) {
+        e |= static_cast<uint64_t>(ehEspaco(p[i])) << i;
+        pt |= static_cast<uint64_t>(ehPontuacao(p[i])) << i;
+    }
+    espacos = e;
+    pontuacao = pt;
+}
+
+#ifdef TEM_X86
+// compara com sinal: bytes >= 0x80 viram negativos e caem fora de todas as faixas
+inline __m128i faixa16(__m128i v, char de, char ate) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(static_cast<char>(de - 1))),
+                         _mm_cmplt_epi8(v, _mm_set1_epi8(static_cast<char>(ate + 1))));
+}
+
+inline void classificarSSE2(const char* p, uint64_t& espacos, uint64_t& pontuacao) {
+    uint64_t e = 0;
+    uint64_t pt = 0;
+    for (int j = 0; j < 4; j++) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * j));
+        __m128i esp = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), faixa16(v, '\t', '\r'));
+        __m128i pon = _mm_or_si128(_mm_or_si128(faixa16(v, '!', '/'), faixa16(v, ':', '@')),
+                                   _mm_or_si128(faixa16(v, '[', '`'), faixa16(v, '{', '~')));
+        e |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(esp))) << (16 * j);
+        pt |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(pon))) << (16 * j);
+    }
+    espacos = e;
+    pontuacao = pt;
+}
+
+__attribute__((target("avx2")))
+inline __m256i faixa32(__m256i v, char de, char ate) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(static_cast<char>(de - 1))),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(ate + 1)), v));
+}
+
+__attribute__((target("avx2")))
+void classificarAVX2(const char* p, uint64_t& espacos, uint64_t& pontuacao) {
+    uint64_t e = 0;
+    uint64_t pt = 0;
+    for (int j = 0; j < 2; j++) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32 * j));
+        __m256i esp = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), faixa32(v, '\t', '\r'));
+        __m256i pon = _mm256_or_si256(_mm256_or_si256(faixa32(v, '!', '/'), faixa32(v, ':', '@')),
+                                      _mm256_or_si256(faixa32(v, '[', '`'), faixa32(v, '{', '~')));
+        e |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(esp))) << (32 * j);
+        pt |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(pon))) << (32 * j);
+    }
+    espacos = e;
+    pontuacao = pt;
+}
+#endif
+
+// escolhe uma vez so qual classificador usar nessa maquina
+inline ClassificadorBloco escolherClassificador(const char** nome = nullptr) {
+#ifdef TEM_X86
+    if (__builtin_cpu_supports("avx2")) {
+        if (nome) *nome = "avx2";
+        return classificarAVX2;
+    }
+    if (nome) *nome = "sse2";
+    return classificarSSE2;
+#else
+    if (nome) *nome = "escalar";
+    return classificarEscalar;
+#endif
+}
+
+// Quebra o texto em palavras direto no buffer, ate o ###, e entrega cada uma ja limpa
+// (mesmo resultado do >> + limpador). Anda de 64 em 64 bytes usando as mascaras: o comeco
+// e o fim de cada palavra saem de ctz nas mascaras de espaco, e a de pontuacao diz se a
+// palavra precisa ser limpa. Palavra sem pontuacao vai como view do proprio texto; com
+// pontuacao, a versao limpa e montada num buffer reaproveitado.
+// Devolve quantos bytes foram consumidos (e se quiser, se parou no ###).
+template <typename F>
+size_t tokenizarTexto(std::string_view texto, F&& entregar, ClassificadorBloco classificar = nullptr,
+                      bool* achouFim = nullptr) {
+    static const ClassificadorBloco padrao = escolherClassificador();
+    if (classificar == nullptr) classificar = padrao;
+    if (achouFim != nullptr) *achouFim = false;
+
+    string limpa;
+    const char* base = texto.data();
+    size_t n = texto.size();
+    bool emPalavra = false;
+    bool suja = false;
+    size_t inicio = 0;
+
+    // devolve false quando achou o ###
+    auto fecharPalavra = [&](size_t fim) {
+        std::string_view palavra(base + inicio, fim - inicio);
+        if (palavra == "###") {
+            return false;
+        }
+        if (!suja) {
+            entregar(palavra);
+            return true;
+        }
+        limpa.clear();
+        for (char c : palavra) {
+            if (!ehPontuacao(c)) limpa += c;
+        }
+        entregar(std::string_view(limpa));
+        return true;
+    };
+
+    char resto[64];
+    for (size_t bloco = 0; bloco < n; bloco += 64) {
+        uint64_t espacos;
+        uint64_t pontuacao;
+        if (n - bloco >= 64) {
+            classificar(base + bloco, espacos, pontuacao);
+        } else {
+            // ultimo pedaco: completa com espaco pra fechar a palavra no fim do texto
+            std::memset(resto, ' ', sizeof(resto));
+            std::memcpy(resto, base + bloco, n - bloco);
+            classificarEscalar(resto, espacos, pontuacao);
+        }
+
+        unsigned pos = 0;
+        while (pos < 64) {
+            uint64_t daqui = ~uint64_t(0) << pos;
+            if (!emPalavra) {
+                uint64_t letras = ~espacos & daqui;
+                if (letras == 0) break;
+                pos = __builtin_ctzll(letras);
+                inicio = bloco + pos;
+                emPalavra = true;
+                suja = false;
+            } else {
+                uint64_t fim = espacos & daqui;
+                unsigned p = fim != 0 ? __builtin_ctzll(fim) : 64;
+                uint64_t ate = p == 64 ? ~uint64_t(0) : (uint64_t(1) << p) - 1;
+                suja |= (pontuacao & daqui & ate) != 0;
+                if (fim == 0) break;
+                emPalavra = false;
+                if (!fecharPalavra(bloco + p)) {
+                    if (achouFim != nullptr) *achouFim = true;
+                    return bloco + p;
+                }
+                pos = p;
+            }
+        }
+    }
+    if (emPalavra) {
+        // texto do tamanho exato de um multiplo de 64 terminando em palavra
+        if (!fecharPalavra(n) && achouFim != nullptr) *achouFim = true;
+    }
+    return n;
+}
+
+// INGESTAO EM FLUXO: le a entrada em blocos de tamanho fixo e vai inserindo numa
+// tabela que ja existe (e continua podendo ser consultada entre um bloco e outro).
+// Cada bloco e cortado no ultimo espaco: a palavra que ficou pela metade no fim e
+// movida pro comeco do buffer e completada pelo proximo bloco. As palavras do bloco
+// vao pra tabela em lotes (insertMany). A memoria e o buffer (um bloco, ou a maior
+// palavra se ela nao couber) e o lote, nao importa o tamanho do texto. Para no ### igual o fluxo padrao.
+// offset() e ate onde a entrada ja foi inteira pra tabela; checkpoint grava a tabela
+// (snapshot) e esse offset, e retomar carrega os dois pra continuar dali.
+template <typename Tabela>
+class IngestaoContinua {
+private:
+    Tabela& tabela;
+    size_t tamBloco;
+    size_t tamLote;
+    vector<char> buffer;            // sobra do bloco anterior + bloco novo
+    size_t usados = 0;              // bytes validos no buffer
+    uint64_t consumido = 0;         // offset no fluxo do comeco do buffer
+    bool terminou = false;
+    vector<std::string_view> lote;
+    std::deque<string> limpas;      // palavras que perderam pontuacao (o tokenizador reusa o buffer dele)
+    size_t palavras = 0;
+
+    void aplicarLote() {
+        tabela.insertMany(lote.data(), lote.size());
+        palavras += lote.size();
+        lote.clear();
+    }
+
+public:
+    explicit IngestaoContinua(Tabela& tabela, size_t tamBloco = 64 * 1024, size_t tamLote = 4096)
+        : tabela(tabela), tamBloco(tamBloco > 0 ? tamBloco : 1), tamLote(tamLote > 0 ? tamLote : 1) {}
+
+    // comeca a contar daqui (entrada que ja foi posicionada no offset de um checkpoint)
+    void comecarEm(uint64_t offset) {
+        consumido = offset;
+        usados = 0;
+        terminou = false;
+    }
+
+    // le e insere um bloco; false quando a entrada acabou (ou achou o ###)
+    bool passo(istream& in) {
+        if (terminou) return false;
+        if (buffer.size() < tamBloco) {
+            buffer.resize(tamBloco);
+        } else if (usados == buffer.size()) {
+            buffer.resize(buffer.size() * 2); // uma palavra maior que o buffer inteiro
+        }
+        // o bloco novo completa o que sobrou do anterior
+        size_t pedidos = buffer.size() - usados;
+        in.read(buffer.data() + usados, pedidos);
+        size_t lidos = static_cast<size_t>(in.gcount());
+        usados += lidos;
+        bool fimEntrada = lidos < pedidos;
+
+        // o que vem depois do ultimo espaco pode continuar no proximo bloco
+        size_t corte = usados;
+        if (!fimEntrada) {
+            while (corte > 0 && !ehEspaco(buffer[corte - 1])) corte--;
+            if (corte == 0) return true; // nem uma palavra inteira ainda: le mais
+        }
+
+        const char* comeco = buffer.data();
+        bool achouFim = false;
+        size_t ate = tokenizarTexto(std::string_view(comeco, corte), [&](std::string_view palavra) {
+            if (palavra.data() < comeco || palavra.data() >= comeco + corte) {
+                limpas.emplace_back(palavra);
+                palavra = limpas.back();
+            }
+            lote.push_back(palavra);
+            if (lote.size() >= tamLote) {
+                aplicarLote();
+                limpas.clear(); // o lote que apontava pra elas ja foi
+            }
+        }, nullptr, &achouFim);
+        aplicarLote();
+        limpas.clear();
+
+        if (achouFim || fimEntrada) {
+            consumido += achouFim ? ate : corte;
+            usados = 0;
+            terminou = true;
+            return false;
+        }
+        consumido += corte;
+        std::memmove(buffer.data(), buffer.data() + corte, usados - corte);
+        usados -= corte;
+        return true;
+    }
+
+    // ate acabar; devolve quantas palavras entraram
+    size_t consumir(istream& in) {
+        while (passo(in)) {
+        }
+        return palavras;
+    }
+
+    uint64_t offset() const { return consumido; }
+    size_t palavrasLidas() const { return palavras; }
+    size_t bytesBuffer() const { return buffer.capacity(); }
+    bool acabou() const { return terminou; }
+
+    // base.snap (tabela) e depois base.pos (offset). Se cair entre os dois, o offset
+    // velho so faz reprocessar um pedaco: inserir palavra que ja ta nao muda nada.
+    bool checkpoint(const string& base) {
+        if (!tabela.save(base + ".snap")) return false;
+        string pos = to_string(consumido) + "\n";
+        return gravarAtomico(base + ".pos", {std::string_view(pos)});
+    }
+    // carrega o snapshot na tabela e devolve o offset pra continuar (false = nao tem
+    // checkpoint valido e a tabela nao e mexida)
+    static bool retomar(Tabela& tabela, const string& base, uint64_t& offset) {
+        ifstream pos(base + ".pos");
+        uint64_t lido;
+        if (!(pos >> lido) || !tabela.load(base + ".snap")) return false;
+        offset = lido;
+        return true;
+    }
+};
+
+// DIARIO (write-ahead log): cada insert/remove vai primeiro pro diario e depois pra
+// tabela, entao depois de cair da pra refazer tudo. Arquivos, todos com o mesmo base:
+//   base.snap        snapshot (o formato de cima)
+//   base.manifesto   primeiro segmento que o snapshot ainda nao cobre
+//   base.N.wal       segmentos do diario, em ordem: cabecalho + registros
+// Registro: checksum (4) | tipo (1) | tamanho (4) | chave. Registro cortado ou com
+// checksum errado no fim do ultimo segmento e escrita que nao terminou: fica fora.
+// Commit em grupo: os registros juntam num buffer e vao pro disco (write + fdatasync)
+// a cada opsPorFsync operacoes. Se cair, perde no maximo o que nao foi sincronizado.
+// Compactar fecha o segmento atual e, numa thread, monta um snapshot novo (snapshot
+// velho + segmentos fechados) sem encostar na tabela viva; a tabela continua recebendo
+// operacoes no segmento novo enquanto isso.
+const char MAGICA_DIARIO[8] = {'P', 'P', '3', 'W', 'A', 'L', '\0', '\0'};
+const uint32_t VERSAO_DIARIO = 1;
+const size_t CABECALHO_DIARIO = 16;  // magica | versao | marcaEndian
+const size_t CABECALHO_REGISTRO = 9; // checksum | tipo | tamanho
+enum TipoRegistro : uint8_t { REGISTRO_INSERIR = 1, REGISTRO_REMOVER = 2 };
+
+inline uint32_t checksumRegistro(uint8_t tipo, std::string_view chave) {
+    uint64_t h = misturar64(tipo, chave.size() + 0x9e3779b97f4a7c15ULL);
+    size_t i = 0;
+    for (; i + 8 <= chave.size(); i += 8) {
+        h = misturar64(h ^ lerPalavra64(chave.data() + i), 0x9e3779b97f4a7c15ULL);
+    }
+    uint64_t resto = 0;
+    memcpy(&resto, chave.data() + i, chave.size() - i);
+    h = misturar64(h ^ resto, 0x9e3779b97f4a7c15ULL);
+    return static_cast<uint32_t>(h ^ (h >> 32));
+}
+
+// so acrescenta no fim; sincronizar espera o disco (fdatasync)
+class ArquivoDiario {
+private:
+#ifdef TEM_MMAP
+    int fd = -1;
+#else
+    std::ofstream out;
+#endif
+
+public:
+    ArquivoDiario() = default;
+    ArquivoDiario(const ArquivoDiario&) = delete;
+    ArquivoDiario& operator=(const ArquivoDiario&) = delete;
+    ~ArquivoDiario() { fechar(); }
+
+    bool abrir(const string& caminho) {
+        fechar();
+#ifdef TEM_MMAP
+        fd = open(caminho.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        return fd >= 0;
+#else
+        out.open(caminho, ios::binary | ios::app);
+        return static_cast<bool>(out);
+#endif
+    }
+    bool escrever(std::string_view dados) {
+#ifdef TEM_MMAP
+        const char* p = dados.data();
+        size_t n = dados.size();
+        while (n > 0) {
+            ssize_t escritos = write(fd, p, n);
+            if (escritos < 0 && errno == EINTR) continue;
+            if (escritos <= 0) return false;
+            p += escritos;
+            n -= escritos;
+        }
+        return true;
+#else
+        out.write(dados.data(), dados.size());
+        return static_cast<bool>(out);
+#endif
+    }
+    bool sincronizar() {
+#ifdef TEM_MMAP
+        return fdatasync(fd) == 0;
+#else
+        return static_cast<bool>(out.flush()); // sem POSIX: fica com o sistema
+#endif
+    }
+    void fechar() {
+#ifdef TEM_MMAP
+        if (fd >= 0) close(fd);
+        fd = -1;
+#else
+        if (out.is_open()) out.close();
+#endif
+    }
+};
+
+inline bool existeArquivo(const string& caminho) {
+    return static_cast<bool>(ifstream(caminho));
+}
+
+inline bool truncarArquivo(const string& caminho, size_t tamanho) {
+#ifdef TEM_MMAP
+    return truncate(caminho.c_str(), static_cast<off_t>(tamanho)) == 0;
+#else
+    string conteudo;
+    {
+        ifstream in(caminho, ios::binary);
+        conteudo.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+    conteudo.resize(min(conteudo.size(), tamanho));
+    return gravarAtomico(caminho, {std::string_view(conteudo)});
+#endif
+}
+
+template <typename Tabela>
+class DiarioTabela {
+private:
+    Tabela& tabela;
+    string base;
+    size_t opsPorFsync;        // 0 = so quando chamar sincronizar (ou o buffer encher)
+    ArquivoDiario arquivo;
+    uint64_t segmento = 0;     // o que esta aberto
+    uint64_t primeiro = 0;     // primeiro que o snapshot nao cobre
+    string pendente;           // registros ainda nao escritos
+    size_t opsPendentes = 0;
+    bool quebrado = false;     // escrita ou fsync falhou: nada mais entra (ver comErro)
+    size_t fsyncs = 0;
+    uint64_t bytesGravados = 0;
+
+    std::thread compactacao;
+    std::atomic<bool> compactando{false};
+    bool okCompactacao = true;
+    uint64_t primeiroDepois = 0; // o que a compactacao que terminou deixou no manifesto
+
+    string nomeSegmento(uint64_t n) const { return base + "." + to_string(n) + ".wal"; }
+
+    static string cabecalhoSegmento() {
+        string cab(CABECALHO_DIARIO, '\0');
+        uint32_t marca = 0x01020304u;
+        memcpy(&cab[0], MAGICA_DIARIO, sizeof(MAGICA_DIARIO));
+        memcpy(&cab[8], &VERSAO_DIARIO, 4);
+        memcpy(&cab[12], &marca, 4);
+        return cab;
+    }
+
+    bool abrirSegmento(uint64_t n) {
+        segmento = n;
+        if (!arquivo.abrir(nomeSegmento(n)) || !arquivo.escrever(cabecalhoSegmento()) || !arquivo.sincronizar()) {
+            quebrado = true;
+            return false;
+        }
+        return true;
+    }
+
+    // poe o registro no pendente e descarrega se deu o intervalo. false = o diario nao
+    // gravou: o registro sai do pendente e quem chamou nao faz a operacao
+    bool registrar(TipoRegistro tipo, std::string_view chave) {
+        if (quebrado) return false;
+        size_t antes = pendente.size();
+        char cab[CABECALHO_REGISTRO];
+        uint32_t soma = checksumRegistro(tipo, chave);
+        uint32_t tamanho = static_cast<uint32_t>(chave.size());
+        memcpy(cab, &soma, 4);
+        cab[4] = static_cast<char>(tipo);
+        memcpy(cab + 5, &tamanho, 4);
+        pendente.append(cab, sizeof(cab));
+        pendente.append(chave.data(), chave.size());
+        opsPendentes++;
+        if (opsPorFsync > 0 ? opsPendentes >= opsPorFsync : pendente.size() >= (1u << 20)) {
+            if (!descarregar(opsPorFsync > 0)) {
+                pendente.resize(antes);
+                opsPendentes--;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // escreve o pendente. Se a escrita ou o fsync falha o pendente fica (sao operacoes
+    // ja feitas na tabela que nao chegaram no disco) e o diario trava: depois de uma
+    // escrita pela metade nao da pra continuar anexando no mesmo segmento.
+    bool descarregar(bool comFsync) {
+        if (quebrado) return false;
+        bool ok = arquivo.escrever(pendente);
+        if (ok && comFsync) {
+            ok = arquivo.sincronizar();
+            fsyncs++;
+        }
+        if (!ok) {
+            quebrado = true;
+            return false;
+        }
+        bytesGravados += pendente.size();
+        pendente.clear();
+        opsPendentes = 0;
+        return true;
+    }
+
+    // aplica os registros de um segmento; 'valido' volta com quantos bytes dele estao
+    // inteiros (menos que o arquivo = tem uma escrita cortada no fim)
+    static bool reaplicar(Tabela& t, const string& caminho, size_t& ops, size_t& valido, size_t& tamanhoArquivo) {
+        ArquivoMapeado dados(caminho);
+        const char* p = dados.data();
+        tamanhoArquivo = dados.size();
+        valido = 0;
+        string cab = cabecalhoSegmento();
+        if (tamanhoArquivo < CABECALHO_DIARIO) return true; // caiu antes de terminar o cabecalho
+        if (memcmp(p, cab.data(), CABECALHO_DIARIO) != 0) return false;
+        size_t pos = CABECALHO_DIARIO;
+        string chave;
+        while (pos + CABECALHO_REGISTRO <= tamanhoArquivo) {
+            uint32_t soma;
+            uint32_t tamanho;
+            memcpy(&soma, p + pos, 4);
+            uint8_t tipo = static_cast<uint8_t>(p[pos + 4]);
+            memcpy(&tamanho, p + pos + 5, 4);
+            if (tamanho > tamanhoArquivo - pos - CABECALHO_REGISTRO) break;
+            std::string_view visao(p + pos + CABECALHO_REGISTRO, tamanho);
+            if (checksumRegistro(tipo, visao) != soma) break;
+            if (tipo == REGISTRO_INSERIR) {
+                t.insert(visao);
+            } else if (tipo == REGISTRO_REMOVER) {
+                chave.assign(visao);
+                t.remove(chave);
+            } else {
+                break;
+            }
+            ops++;
+            pos += CABECALHO_REGISTRO + tamanho;
+        }
+        valido = pos;
+        return true;
+    }
+
+    static bool gravarManifesto(const string& base, uint64_t n) {
+        string texto = to_string(n) + "\n";
+        return gravarAtomico(base + ".manifesto", {std::string_view(texto)});
+    }
+
+    // roda na thread: snapshot velho + segmentos [de, ate) -> snapshot novo
+    static bool compactarSegmentos(string base, size_t gavetas, uint64_t de, uint64_t ate) {
+        Tabela nova(gavetas);
+        if (existeArquivo(base + ".snap") && !nova.load(base + ".snap")) return false;
+        for (uint64_t n = de; n < ate; n++) {
+            size_t ops = 0, valido = 0, tamanho = 0;
+            string caminho = base + "." + to_string(n) + ".wal";
+            if (!reaplicar(nova, caminho, ops, valido, tamanho)) return false;
+        }
+        // snapshot primeiro, manifesto depois: cair entre os dois so refaz segmentos que
+        // o snapshot ja tem (insert/remove de novo na mesma ordem da o mesmo conjunto)
+        if (!nova.save(base + ".snap") || !gravarManifesto(base, ate)) return false;
+        for (uint64_t n = de; n < ate; n++) {
+            std::remove((base + "." + to_string(n) + ".wal").c_str());
+        }
+        return true;
+    }
+
+    void juntarCompactacao() {
+        if (compactacao.joinable()) {
+            compactacao.join();
+            if (okCompactacao) primeiro = primeiroDepois;
+        }
+    }
+
+public:
+    DiarioTabela(Tabela& tabela, const string& base, size_t opsPorFsync = 64)
+        : tabela(tabela), base(base), opsPorFsync(opsPorFsync) {}
+    DiarioTabela(const DiarioTabela&) = delete;
+    DiarioTabela& operator=(const DiarioTabela&) = delete;
+    ~DiarioTabela() {
+        juntarCompactacao();
+        sincronizar();
+    }
+
+    // RECUPERACAO: carrega o snapshot (se tiver) na tabela, refaz os segmentos depois
+    // dele e abre um segmento novo pra continuar. Sem snapshot a tabela tem que vir
+    // vazia. false = arquivo estragado que nao e so uma escrita cortada no fim.
+    bool abrir(size_t* refeitas = nullptr) {
+        quebrado = false;
+        pendente.clear();
+        opsPendentes = 0;
+        uint64_t n = 0;
+        ifstream manifesto(base + ".manifesto");
+        if (!(manifesto >> n)) n = 0;
+        primeiro = n;
+        if (existeArquivo(base + ".snap")) {
+            if (!tabela.load(base + ".snap")) return false;
+        } else if (n > 0) {
+            return false; // o manifesto diz que tem snapshot
+        }
+        // sobra de uma compactacao que caiu depois do manifesto
+        for (uint64_t velho = n; velho > 0 && existeArquivo(nomeSegmento(velho - 1)); velho--) {
+            std::remove(nomeSegmento(velho - 1).c_str());
+        }
+        size_t ops = 0;
+        for (; existeArquivo(nomeSegmento(n)); n++) {
+            size_t valido = 0, tamanho = 0;
+            if (!reaplicar(tabela, nomeSegmento(n), ops, valido, tamanho)) return false;
+            if (valido < tamanho) {
+                // escrita cortada: so pode ser no ultimo segmento
+                if (existeArquivo(nomeSegmento(n + 1))) return false;
+                if (!truncarArquivo(nomeSegmento(n), valido)) return false;
+            }
+        }
+        if (refeitas != nullptr) *refeitas = ops;
+        return abrirSegmento(n);
+    }
+
+    // false = o diario nao conseguiu gravar (disco cheio, erro de E/S): a tabela fica
+    // como estava e, dali pra frente, toda operacao e recusada (comErro)
+    bool insert(std::string_view chave) {
+        if (!registrar(REGISTRO_INSERIR, chave)) return false;
+        tabela.insert(chave);
+        return true;
+    }
+    bool remove(std::string_view chave) {
+        if (!registrar(REGISTRO_REMOVER, chave)) return false;
+        tabela.remove(string(chave));
+        return true;
+    }
+
+    // tudo que ja foi feito vai pro disco; false = nao foi (e o diario trava)
+    bool sincronizar() {
+        if (quebrado) return false;
+        if (opsPendentes == 0 && pendente.empty()) return true;
+        return descarregar(true);
+    }
+    // travou numa falha de escrita: as operacoes depois do ultimo sincronizar que deu
+    // certo podem nao estar no disco. Pra continuar, recuperar com abrir numa tabela
+    // nova (refaz o que chegou no disco).
+    bool comErro() const { return quebrado; }
+
+    // fecha o segmento atual e compacta em segundo plano; false se ja tem uma rodando
+    bool compactar() {
+        if (compactando.load()) return false;
+        juntarCompactacao();
+        if (!sincronizar()) return false;
+        uint64_t ate = segmento + 1;
+        if (!abrirSegmento(ate)) return false;
+        compactando = true;
+        primeiroDepois = ate;
+        compactacao = std::thread([this, de = primeiro, ate, gavetas = tabela.gavetas(), b = base] {
+            okCompactacao = compactarSegmentos(b, gavetas, de, ate);
+            compactando = false;
+        });
+        return true;
+    }
+    bool esperarCompactacao() {
+        juntarCompactacao();
+        return okCompactacao;
+    }
+
+    size_t numFsyncs() const { return fsyncs; }
+    uint64_t bytes() const { return bytesGravados; }
+    uint64_t segmentoAtual() const { return segmento; }
+    uint64_t primeiroSegmento() const { return primeiro; }
+};
+
+template <typename T, typename HashPolicy, typename Balde>
+void HashTable<T, HashPolicy, Balde>::construirParalelo(std::string_view texto, unsigned numThreads) {
+    if (numThreads == 0) numThreads = 1;
+    while (antiga != nullptr) {
+        migrarPasso();
+    }
+
+    // pedacos do texto: cada corte anda ate o proximo espaco pra nao partir palavra
+    vector<size_t> cortes(numThreads + 1, texto.size());
+    cortes[0] = 0;
+    for (unsigned t = 1; t < numThreads; t++) {
+        size_t c = max(cortes[t - 1], texto.size() * t / numThreads);
+        while (c < texto.size() && c > 0 && !ehEspaco(texto[c - 1])) c++;
+        cortes[t] = c;
+    }
+
+    // fase 1: quebra + hash. filas[pedaco][dona] guarda (gaveta, palavra)
+    typedef vector<pair<uint32_t, std::string_view>> Fila;
+    vector<vector<Fila>> filas(numThreads, vector<Fila>(numThreads));
+    vector<std::deque<string>> limpas(numThreads); // palavras que perderam pontuacao
+    vector<char> parouNoFim(numThreads, 0);
+    auto quebrar = [&](unsigned t) {
+        bool achou = false;
+        tokenizarTexto(texto.substr(cortes[t], cortes[t + 1] - cortes[t]), [&](std::string_view palavra) {
+            if (palavra.data() < texto.data() || palavra.data() >= texto.data() + texto.size()) {
+                limpas[t].emplace_back(palavra);
+                palavra = limpas[t].back();
+            }
+            size_t g = Hash(palavra);
+            filas[t][g * numThreads / SIZE].push_back({static_cast<uint32_t>(g), palavra});
+        }, nullptr, &achou);
+        parouNoFim[t] = achou;
+    };
+
+    // fase 2: cada dona insere nas gavetas dela, pedaco por pedaco em ordem
+    for (unsigned t = 0; t < numThreads; t++) {
+        arenasThreads.emplace_back();
+    }
+    auto arenaDe = arenasThreads.end() - numThreads;
+    vector<size_t> inseridos(numThreads, 0);
+    unsigned ultimoPedaco = numThreads; // pedacos depois do ### nao contam
+    auto inserir = [&](unsigned dona) {
+        typename Balde::Arena* minhaArena = &arenaDe[dona];
+        for (unsigned t = 0; t < ultimoPedaco; t++) {
+            for (const auto& par : filas[t][dona]) {
+                Balde*& arvore = tabela[par.first];
+                if (arvore == nullptr) {
+                    arvore = new Balde(minhaArena);
+                } else {
+                    arvore->setArena(minhaArena);
+                }
+                int antes = arvore->size();
+                arvore->Insert(par.second);
+                inseridos[dona] += arvore->size() - antes;
+            }
+        }
+    };
+
+    auto rodar = [numThreads](auto& tarefa) {
+        vector<std::thread> threads;
+        for (unsigned t = 1; t < numThreads; t++) {
+            threads.emplace_back(tarefa, t);
+        }
+        tarefa(0);
+        for (auto& th : threads) th.join();
+    };
+    rodar(quebrar);
+    for (unsigned t = 0; t < numThreads; t++) {
+        if (parouNoFim[t]) {
+            ultimoPedaco = t + 1;
+            break;
+        }
+    }
+    rodar(inserir);
+
+    for (size_t n : inseridos) numItens += n;
+    SO_ESTATISTICA(publicarGavetas();)
+    if (fatorCarga > 0 && numItens > fatorCarga * SIZE) {
+        crescer();
+    }
+}
+
+// le o texto ate o ### (ou ate 'limite' palavras) e entrega cada palavra ja limpa pro
+// 'usar', na ordem, sem guardar nenhuma
+template <typename F>
+void paraCadaPalavra(istream& in, F usar, size_t limite = SIZE_MAX) {
+    string palavra;
+    for (size_t n = 0; n < limite && in >> palavra && palavra != "###"; n++) {
+        usar(limpador(palavra));
+    }
+}
+
+// o mesmo, devolvendo todas num vetor
+vector<string> lerPalavras(istream& in, size_t limite = SIZE_MAX) {
+    vector<string> palavras;
+    paraCadaPalavra(in, [&](string&& palavra) { palavras.push_back(std::move(palavra)); }, limite);
+    return palavras;
+}
+
+// mesmas palavras do lerPalavras, mas sem copiar: as views apontam pro arquivo e as
+// que tiveram pontuacao tirada ficam guardadas em limpas (deque: nao muda de lugar
+// quando cresce). O arquivo e o limpas tem que viver enquanto as views forem usadas.
+vector<std::string_view> lerPalavrasMapeadas(const ArquivoMapeado& arquivo, deque<string>& limpas) {
+    vector<std::string_view> palavras;
+    tokenizarTexto(arquivo.conteudo(), [&](std::string_view palavra) {
+        if (palavra.data() >= arquivo.data() && palavra.data() < arquivo.data() + arquivo.size()) {
+            palavras.push_back(palavra);
+        } else {
+            limpas.emplace_back(palavra);
+            palavras.push_back(limpas.back());
+        }
+    });
+    return palavras;
+}
+
+// BENCHMARK DAS POLITICAS DE HASH
+// chaves/s hasheando o texto inteiro varias vezes + como as palavras distintas
+// se espalham nas gavetas (tamanho de cada arvore)
+template <typename HashPolicy>
+void benchHash(const vector<string>& palavras, const vector<string>& distintas, size_t gavetas) {
+    HashPolicy politica;
+    const int repeticoes = 200;
+
+    size_t soma = 0; // so pro compilador nao jogar o laco fora
+    auto inicio = chrono::steady_clock::now();
+    for (int r = 0; r < repeticoes; r++) {
+        for (const string& p : palavras) {
+            soma += politica(p, gavetas);
+        }
+    }
+    chrono::duration<double> tempo = chrono::steady_clock::now() - inicio;
+    double chavesPorSeg = (static_cast<double>(palavras.size()) * repeticoes) / tempo.count();
+
+    vector<size_t> tamanhos(gavetas, 0);
+    for (const string& d : distintas) {
+        tamanhos[politica(d, gavetas)]++;
+    }
+    size_t vazias = 0;
+    size_t maior = 0;
+    for (size_t t : tamanhos) {
+        if (t == 0) vazias++;
+        maior = max(maior, t);
+    }
+    double media = static_cast<double>(distintas.size()) / gavetas;
+    double variancia = 0;
+    for (size_t t : tamanhos) {
+        variancia += (t - media) * (t - media);
+    }
+    variancia /= gavetas;
+
+    cout << HashPolicy::nome << ": " << chavesPorSeg / 1e6 << " M chaves/s"
+         << " | vazias: " << vazias << " | maior: " << maior
+         << " | media: " << media << " | desvio: " << sqrt(variancia)
+         << " (" << soma % 2 << ")" << endl;
+}
+
+void rodarBenchHash(istream& in) {
+    vector<string> palavras = lerPalavras(in);
+    vector<string> distintas = palavras;
+    sort(distintas.begin(), distintas.end());
+    distintas.erase(unique(distintas.begin(), distintas.end()), distintas.end());
+
+    cout << palavras.size() << " palavras, " << distintas.size() << " distintas" << endl;
+    const size_t gavetas = 151;
+    benchHash<HashLegado>(palavras, distintas, gavetas);
+    benchHash<HashHorner>(palavras, distintas, gavetas);
+    benchHash<HashFNV1a>(palavras, distintas, gavetas);
+    benchHash<HashMistura64>(palavras, distintas, gavetas);
+    benchHash<HashBlocos>(palavras, distintas, gavetas);
+}
+
+
+
+// confere as alturas das arvores dos nomes de teste (o mesmo pra qualquer jeito de montar a tabela)
+template <typename Tabela>
+void testarAlturas(Tabela& tabela) {
+    // ---- TESTADOR DE PROGRAMA AQUI ----
+    // TERMINOU? NAO ESQUECER DE TIRAR O INCLUDE <vector>
+    // USANDO VECTOR APENAS PARA TESTAR AS PALAVRAS CHAVES
+    // USANDO PRA ARMAZENAR AS ALTURAS
+    // -1 REPRESENTA NAO ENCONTRADO
+    // como usar o testador -> COLE O TEXTO BASE E Dê ENTER DUAS VEZES
+    vector<std::string> nomes = {
+        "Frodo", "Bilbo", "Legolas", "Pippin", "Merry",
+        "Galadriel", "Butterbur", "Sam", "Faramir", "Peregrin",
+        "Gandalf", "Gollum", "Bombadil", "Elrond", "Sauron",
+        "Aragorn", "Saruman", "Gildor", "Elanor", "Morgoth"
+    };
+    vector<int> valores = {
+        6, 6, -1, 7, 7, -1, 6, 6, -1,
+        6, 7, 7, 6, 7, 6, 6, 6, 6, -1, -1
+    };
+
+    int erro_n = 0;
+    int acerto_n = 0;
+
+    for (size_t i = 0; i < valores.size(); i++) {
+        string palavraChave = limpador(nomes[i]);
+        /*
+        if (!palavraChave.empty()) {
+            if (tabela.buscarMostrarAltura(palavraChave) != -1) {
+                cout << palavraChave << tabela.buscarMostrarAltura(palavraChave) << endl;
+            } else {
+                cout << "Nao encontrado" << endl;
+            }
+           }
+        */
+
+        if (tabela.buscarMostrarAltura(palavraChave) == valores[i]) {
+            cout << palavraChave << ": " << tabela.buscarMostrarAltura(palavraChave) << " - "<< "CORRETO" << endl;
+            acerto_n++;
+        } else {
+            cout << palavraChave << ": " << tabela.buscarMostrarAltura(palavraChave) << " - " << "ERRADO" << endl;
+            erro_n++;
+        }
+    }
+
+    cout << endl;
+    cout << "acertos: " << acerto_n << endl;
+    cout << "erros: " << erro_n << endl;
+}
+
+// CONFERE O TOKENIZADOR: cada versao (escalar/sse2/avx2) tem que dar exatamente
+// as mesmas palavras que o >> + limpador, e mede MB/s de cada uma
+void rodarConferirTokens(const string& caminho) {
+    ArquivoMapeado arquivo(caminho);
+    if (arquivo.data() == nullptr) {
+        cout << "nao consegui abrir " << caminho << endl;
+        return;
+    }
+    istringstream entrada{string(arquivo.conteudo())};
+    vector<string> esperado = lerPalavras(entrada);
+
+    vector<pair<const char*, ClassificadorBloco>> versoes = {{"escalar", classificarEscalar}};
+#ifdef TEM_X86
+    versoes.push_back({"sse2", classificarSSE2});
+    if (__builtin_cpu_supports("avx2")) {
+        versoes.push_back({"avx2", classificarAVX2});
+    }
+#endif
+    const char* escolhido = nullptr;
+    escolherClassificador(&escolhido);
+    cout << "classificador escolhido: " << escolhido << endl;
+
+    for (const auto& versao : versoes) {
+        size_t i = 0;
+        bool igual = true;
+        tokenizarTexto(arquivo.conteudo(), [&](std::string_view palavra) {
+            if (i >= esperado.size() || esperado[i] != palavra) igual = false;
+            i++;
+        }, versao.second);
+        igual = igual && i == esperado.size();
+
+        const int repeticoes = 20;
+        size_t total = 0;
+        auto inicio = chrono::steady_clock::now();
+        for (int r = 0; r < repeticoes; r++) {
+            tokenizarTexto(arquivo.conteudo(), [&](std::string_view palavra) { total += palavra.size(); }, versao.second);
+        }
+        chrono::duration<double> tempo = chrono::steady_clock::now() - inicio;
+        double mb = arquivo.size() * static_cast<double>(repeticoes) / (1024.0 * 1024.0);
+        cout << versao.first << ": " << (igual ? "IGUAL" : "DIFERENTE") << " ao limpador, "
+             << mb / tempo.count() << " MB/s (" << total % 2 << ")" << endl;
+    }
+}
+
+// CARGA EM LOTE x INSERT POR INSERT: mesmo texto, mede as duas e confere o resultado
+void rodarBulk(const string& caminho) {
+    ArquivoMapeado arquivo(caminho);
+    if (arquivo.data() == nullptr) {
+        cout << "nao consegui abrir " << caminho << endl;
+        return;
+    }
+    deque<string> limpas;
+    vector<std::string_view> palavras = lerPalavrasMapeadas(arquivo, limpas);
+
+    auto inicio = chrono::steady_clock::now();
+    HashTable<string> incremental;
+    for (std::string_view palavra : palavras) {
+        incremental.insert(palavra);
+    }
+    chrono::duration<double> tempoIncremental = chrono::steady_clock::now() - inicio;
+
+    inicio = chrono::steady_clock::now();
+    HashTable<string> lote;
+    lote.bulkLoad(palavras);
+    chrono::duration<double> tempoLote = chrono::steady_clock::now() - inicio;
+
+    bool igual = lote.length() == incremental.length();
+    for (std::string_view palavra : palavras) {
+        igual = igual && lote.search(palavra);
+    }
+    cout << palavras.size() << " palavras, " << lote.length() << " distintas" << endl;
+    cout << "insert por insert: " << tempoIncremental.count() * 1000 << " ms" << endl;
+    cout << "carga em lote:     " << tempoLote.count() * 1000 << " ms ("
+         << tempoIncremental.count() / tempoLote.count() << "x)" << endl;
+    cout << "mesmas chaves: " << (igual ? "sim" : "NAO") << endl;
+    cout << "arvores AVL validas: " << (lote.conferirArvores() ? "sim" : "NAO") << endl;
+}
+
+// BALDE AVL x BALDE PLANO: mesmas chaves nas duas tabelas, mede buscas/s com acerto
+// (na ordem do texto, entao as palavras comuns repetem) e com erro. Com menos gavetas
+// cada balde fica maior e o layout pesa mais.
+template <typename Tabela>
+double medirBuscas(Tabela& tabela, const vector<std::string_view>& consultas, size_t& achados) {
+    const size_t alvo = 4000000; // mais ou menos o mesmo tanto de busca em qualquer texto
+    size_t repeticoes = consultas.empty() ? 1 : (alvo + consultas.size() - 1) / consultas.size();
+    achados = 0;
+    auto inicio = chrono::steady_clock::now();
+    for (size_t r = 0; r < repeticoes; r++) {
+        for (std::string_view chave : consultas) {
+            achados += tabela.search(chave);
+        }
+    }
+    chrono::duration<double> tempo = chrono::steady_clock::now() - inicio;
+    achados /= repeticoes;
+    return consultas.size() * static_cast<double>(repeticoes) / tempo.count();
+}
+
+void rodarBenchBaldes(const string& caminho) {
+    ArquivoMapeado arquivo(caminho);
+    if (arquivo.data() == nullptr) {
+        cout << "nao consegui abrir " << caminho << endl;
+        return;
+    }
+    deque<string> limpas;
+    vector<std::string_view> palavras = lerPalavrasMapeadas(arquivo, limpas);
+    // erros: cada palavra distinta com um caractere a mais no fim (mesmo prefixo, pior caso)
+    vector<string> distintas(palavras.begin(), palavras.end());
+    sort(distintas.begin(), distintas.end());
+    distintas.erase(unique(distintas.begin(), distintas.end()), distintas.end());
+    vector<string> inexistentes;
+    for (const string& palavra : distintas) inexistentes.push_back(palavra + "~");
+    vector<std::string_view> erros(inexistentes.begin(), inexistentes.end());
+
+    cout << palavras.size() << " palavras, " << distintas.size() << " distintas" << endl;
+    for (size_t gavetas : {151, 31, 7}) {
+        HashTable<string> avl(gavetas);
+        HashTable<string, HashLegado, BaldeEytzinger<string>> plano(gavetas);
+        avl.bulkLoad(palavras);
+        plano.bulkLoad(palavras);
+
+        size_t achadosAvl, achadosPlano, falsosAvl, falsosPlano;
+        double acertoAvl = medirBuscas(avl, palavras, achadosAvl);
+        double acertoPlano = medirBuscas(plano, palavras, achadosPlano);
+        double erroAvl = medirBuscas(avl, erros, falsosAvl);
+        double erroPlano = medirBuscas(plano, erros, falsosPlano);
+        bool certo = achadosAvl == palavras.size() && achadosPlano == palavras.size() &&
+                     falsosAvl == 0 && falsosPlano == 0 && plano.conferirArvores();
+
+        cout << endl << gavetas << " gavetas (~" << distintas.size() / gavetas << " chaves por gaveta)" << endl;
+        cout << "  acerto: avl " << acertoAvl / 1e6 << " M/s, plano " << acertoPlano / 1e6 << " M/s ("
+             << acertoPlano / acertoAvl << "x)" << endl;
+        cout << "  erro:   avl " << erroAvl / 1e6 << " M/s, plano " << erroPlano / 1e6 << " M/s ("
+             << erroPlano / erroAvl << "x)" << endl;
+        cout << "  resultados iguais: " << (certo ? "sim" : "NAO") << endl;
+    }
+}
+
+// CHAVE INTERNADA x STRING: mesma tabela com os dois tipos de chave, mostra quantos
+// bytes cada palavra distinta custa (nos + texto + vetor de gavetas) e buscas/s
+void rodarInternado(const string& caminho) {
+    ArquivoMapeado arquivo(caminho);
+    if (arquivo.data() == nullptr) {
+        cout << "nao consegui abrir " << caminho << endl;
+        return;
+    }
+    deque<string> limpas;
+    vector<std::string_view> palavras = lerPalavrasMapeadas(arquivo, limpas);
+
+    auto inicio = chrono::steady_clock::now();
+    HashTable<string> comum;
+    for (std::string_view palavra : palavras) comum.insert(palavra);
+    chrono::duration<double> tempoComum = chrono::steady_clock::now() - inicio;
+
+    PoolPalavras& pool = PoolPalavras::global();
+    size_t poolAntes = pool.bytesUsados();
+    inicio = chrono::steady_clock::now();
+    HashTable<ChaveInterna> internada;
+    for (std::string_view palavra : palavras) internada.insert(palavra);
+    chrono::duration<double> tempoInternada = chrono::steady_clock::now() - inicio;
+    size_t bytesPool = pool.bytesUsados() - poolAntes;
+
+    // texto das strings: so as que nao cabem no buffer interno (SSO) vao pro heap
+    vector<std::string_view> distintas(palavras.begin(), palavras.end());
+    sort(distintas.begin(), distintas.end());
+    distintas.erase(unique(distintas.begin(), distintas.end()), distintas.end());
+    size_t heapStrings = 0;
+    for (std::string_view palavra : distintas) {
+        if (palavra.size() > string().capacity()) heapStrings += palavra.size() + 1;
+    }
+
+    bool certo = comum.length() == internada.length() && internada.conferirArvores();
+    for (std::string_view palavra : distintas) {
+        certo = certo && internada.search(palavra) && !internada.search(string(palavra) + "~");
+    }
+
+    double n = static_cast<double>(distintas.size());
+    size_t gavetas = comum.gavetas() * sizeof(void*);
+    size_t totalComum = comum.bytesVivos() + heapStrings + gavetas;
+    size_t totalInternada = internada.bytesVivos() + bytesPool + gavetas;
+    cout << palavras.size() << " palavras, " << distintas.size() << " distintas" << endl;
+    cout << "no: " << sizeof(BSTNode<string>) << " bytes com string, " << sizeof(BSTNode<ChaveInterna>)
+         << " bytes com chave internada" << endl;
+    cout << "string:    " << totalComum / n << " bytes por chave (nos " << comum.bytesVivos() / n
+         << ", heap " << heapStrings / n << ", gavetas " << gavetas / n << ")" << endl;
+    cout << "internada: " << totalInternada / n << " bytes por chave (nos " << internada.bytesVivos() / n
+         << ", pool " << bytesPool / n << ", gavetas " << gavetas / n << ")" << endl;
+    cout << "economia: " << 100.0 * (1.0 - static_cast<double>(totalInternada) / totalComum) << "%" << endl;
+    cout << "construcao: string " << tempoComum.count() * 1000 << " ms, internada "
+         << tempoInternada.count() * 1000 << " ms" << endl;
+
+    size_t achados;
+    double buscasComum = medirBuscas(comum, palavras, achados);
+    double buscasInternada = medirBuscas(internada, palavras, achados);
+    cout << "buscas: string " << buscasComum / 1e6 << " M/s, internada " << buscasInternada / 1e6 << " M/s ("
+         << buscasInternada / buscasComum << "x)" << endl;
+    cout << "mesmas chaves: " << (certo && achados == palavras.size() ? "sim" : "NAO") << endl;
+}
+
+// OPERACOES DA ARVORE: ns por operacao numa BST sozinha (sem a tabela na frente),
+// com as palavras distintas embaralhadas e em ordem (em ordem e o pior caso de rotacao).
+// Insert, busca e remove rodam na versao iterativa e na recursiva antiga, lado a lado
+// (as duas tem que sair com a mesma arvore)
+void rodarBenchArvore(const string& caminho) {
+    ArquivoMapeado arquivo(caminho);
+    if (arquivo.data() == nullptr) {
+        cout << "nao consegui abrir " << caminho << endl;
+        return;
+    }
+    vector<string> palavras;
+    tokenizarTexto(arquivo.conteudo(), [&](std::string_view palavra) { palavras.emplace_back(palavra); });
+    sort(palavras.begin(), palavras.end());
+    palavras.erase(unique(palavras.begin(), palavras.end()), palavras.end());
+    vector<string> embaralhadas = palavras;
+    mt19937 gerador(42);
+    shuffle(embaralhadas.begin(), embaralhadas.end(), gerador);
+
+    auto medir = [](auto&& passo) {
+        auto inicio = chrono::steady_clock::now();
+        passo();
+        return chrono::duration<double, std::nano>(chrono::steady_clock::now() - inicio).count();
+    };
+    // pre-ordem com altura: duas arvores com a mesma sequencia tem o mesmo formato
+    auto formato = [](const BST<string>& arvore) {
+        vector<pair<string, int>> nos;
+        arvore.EmPreOrdem([&nos](const BSTNode<string>& node) { nos.emplace_back(node.getItem(), node.getHeight()); });
+        return nos;
+    };
+    const int repeticoes = 10;
+    for (const auto& ordem : {make_pair("embaralhadas", &embaralhadas), make_pair("em ordem", &palavras)}) {
+        const vector<string>& chaves = *ordem.second;
+        // [0] = iterativa (a de verdade), [1] = recursiva antiga
+        double tInsert[2] = {0, 0}, tBusca[2] = {0, 0}, tRemove[2] = {0, 0};
+        double tDestroi = 0;
+        int altura = 0;
+        size_t achados[2] = {0, 0};
+        bool mesmaArvore = true;
+        for (int r = 0; r < repeticoes; r++) {
+            ArenaNos<BSTNode<string>> arena;
+            ArenaNos<BSTNode<string>> arenaRecursiva;
+            BST<string>* arvore = new BST<string>(&arena);
+            BST<string> recursiva(&arenaRecursiva);
+            // alterna quem vai primeiro (o segundo pega o cache e o alocador quentes)
+            auto iterativo = [&] {
+                tInsert[0] += medir([&] { for (const string& k : chaves) arvore->Insert(k); });
+                tBusca[0] += medir([&] { for (const string& k : embaralhadas) achados[0] += arvore->Search(k) != nullptr; });
+            };
+            auto recursivo = [&] {
+                tInsert[1] += medir([&] { for (const string& k : chaves) recursiva.InsertRecursivo(k); });
+                tBusca[1] += medir([&] { for (const string& k : embaralhadas) achados[1] += recursiva.SearchRecursivo(k) != nullptr; });
+            };
+            if (r % 2 == 0) {
+                iterativo();
+                recursivo();
+            } else {
+                recursivo();
+                iterativo();
+            }
+            altura = arvore->altura();
+            mesmaArvore = mesmaArvore && formato(*arvore) == formato(recursiva);
+            // remove metade (as chaves de indice par) e confere o formato de novo
+            auto remover = [&](int qual) {
+                tRemove[qual] += medir([&] {
+                    for (size_t i = 0; i < chaves.size(); i += 2) {
+                        if (qual == 0) arvore->Remove(chaves[i]);
+                        else recursiva.RemoveRecursivo(chaves[i]);
+                    }
+                });
+            };
+            remover(r % 2);
+            remover(1 - r % 2);
+            mesmaArvore = mesmaArvore && formato(*arvore) == formato(recursiva) && arvore->ConferirAVL();
+            for (size_t i = 0; i < chaves.size(); i += 2) arvore->Insert(chaves[i]);
+            tDestroi += medir([&] { delete arvore; }); // destroy no por no (sem Abandonar)
+        }
+        double ops = static_cast<double>(chaves.size()) * repeticoes;
+        double opsRemove = static_cast<double>((chaves.size() + 1) / 2) * repeticoes;
+        cout << ordem.first << ": " << chaves.size() << " chaves, altura " << altura << ", mesma arvore nas duas: "
+             << (mesmaArvore && achados[0] == achados[1] ? "sim" : "NAO") << endl;
+        auto linha = [&](const char* nome, const double* t, double n) {
+            cout << "  " << nome << ": iterativo " << t[0] / n << " ns, recursivo " << t[1] / n << " ns ("
+                 << t[1] / t[0] << "x)" << endl;
+        };
+        linha("insert", tInsert, ops);
+        linha("busca ", tBusca, ops);
+        linha("remove", tRemove, opsRemove);
+        cout << "  destroy " << tDestroi / ops << " ns por no (" << achados[0] / repeticoes << " achados)" << endl;
+    }
+}
+
+// BUSCA EM LOTE: search uma por uma x searchMany com lotes de tamanhos diferentes.
+// Metade das consultas existe; ordem sorteada (semente fixa) pra nao ajudar o cache.
+// Tabela fixa de 151 gavetas (cabe no cache) e uma crescendo com fator 2 (gavetas espalhadas).
+void rodarBenchLote(const string& caminho) {
+    ArquivoMapeado arquivo(caminho);
+    if (arquivo.data() == nullptr) {
+        cout << "nao consegui abrir " << caminho << endl;
+        return;
+    }
+    vector<string> palavras;
+    tokenizarTexto(arquivo.conteudo(), [&](std::string_view palavra) { palavras.emplace_back(palavra); });
+    sort(palavras.begin(), palavras.end());
+    palavras.erase(unique(palavras.begin(), palavras.end()), palavras.end());
+    vector<string> consultas;
+    for (const string& palavra : palavras) {
+        consultas.push_back(palavra);
+        consultas.push_back(palavra + "~");
+    }
+    mt19937 gerador(42);
+    shuffle(consultas.begin(), consultas.end(), gerador);
+    vector<std::string_view> visoes(consultas.begin(), consultas.end());
+    const size_t n = visoes.size();
+    std::unique_ptr<bool[]> resultados(new bool[n]);
+    std::unique_ptr<bool[]> esperado(new bool[n]);
+
+    HashTable<string> fixa;
+    HashTable<string> crescendo(151, 2.0);
+    fixa.bulkLoad(palavras);
+    crescendo.bulkLoad(palavras);
+    cout << palavras.size() << " chaves, " << n << " consultas" << endl;
+
+    auto medir = [&](auto& tabela, size_t lote) {
+        auto inicio = chrono::steady_clock::now();
+        for (int r = 0; r < 3; r++) {
+            if (lote == 0) {
+                for (size_t i = 0; i < n; i++) resultados[i] = tabela.search(visoes[i]);
+            } else {
+                for (size_t i = 0; i < n; i += lote) {
+                    tabela.searchMany(visoes.data() + i, min(lote, n - i), resultados.get() + i);
+                }
+            }
+        }
+        chrono::duration<double> tempo = chrono::steady_clock::now() - inicio;
+        return 3.0 * n / tempo.count();
+    };
+    auto rodar = [&](const char* nome, auto& tabela) {
+        medir(tabela, 0);
+        std::copy(resultados.get(), resultados.get() + n, esperado.get());
+        double base = medir(tabela, 0);
+        cout << endl << nome << " (" << tabela.gavetas() << " gavetas)" << endl;
+        cout << "  search um por um: " << base / 1e6 << " M/s" << endl;
+        for (size_t lote : {1, 2, 4, 16, 64, 256, 1024, 4096, 16384}) {
+            double taxa = medir(tabela, lote);
+            bool igual = std::equal(resultados.get(), resultados.get() + n, esperado.get());
+            cout << "  lote " << lote << ": " << taxa / 1e6 << " M/s (" << taxa / base << "x)"
+                 << (igual ? "" : " DIFERENTE") << endl;
+        }
+    };
+    rodar("fixa", fixa);
+    rodar("crescendo", crescendo);
+}
+
+// FASE DE ESTAGIO DO MAIN: le com >> + limpador pra List e depois esvazia pela frente
+// inserindo na tabela (igual o fluxo padrao), medindo cada parte e a memoria da List
+void rodarBenchLista(const string& caminho) {
+    ifstream arquivo(caminho);
+    if (!arquivo) {
+        cout << "nao consegui abrir " << caminho << endl;
+        return;
+    }
+    vector<string> palavras = lerPalavras(arquivo); // le antes pra medir so a List
+
+    auto inicio = chrono::steady_clock::now();
+    List<string> lista;
+    for (const string& p : palavras) {
+        lista.insertBack(p);
+    }
+    chrono::duration<double> tempoEnche = chrono::steady_clock::now() - inicio;
+    size_t bytes = lista.bytesReservados();
+    int n = lista.size();
+
+    inicio = chrono::steady_clock::now();
+    HashTable<string> tabela;
+    while (!lista.empty()) {
+        tabela.insert(lista.popFront());
+    }
+    chrono::duration<double> tempoEsvazia = chrono::steady_clock::now() - inicio;
+
+    // pelo fim agora tambem e O(1)
+    for (const string& p : palavras) {
+        lista.insertBack(p);
+    }
+    inicio = chrono::steady_clock::now();
+    while (!lista.empty()) {
+        lista.removeBack();
+    }
+    chrono::duration<double> tempoFim = chrono::steady_clock::now() - inicio;
+
+    cout << n << " palavras na lista" << endl;
+    cout << "memoria da lista: " << static_cast<double>(bytes) / n << " bytes por item (sem o heap das strings)" << endl;
+    cout << "insertBack: " << tempoEnche.count() * 1e9 / n << " ns por item" << endl;
+    cout << "popFront + insert na tabela: " << tempoEsvazia.count() * 1e9 / n << " ns por item" << endl;
+    cout << "removeBack: " << tempoFim.count() * 1e9 / n << " ns por item" << endl;
+}
+
+// FREQUENCIA DE PALAVRAS: conta tudo numa passada so com MapaHash::increment e
+// compara com o jeito antigo (HashTable<string> pro conjunto + std::map pra contar,
+// duas estruturas e duas descidas por palavra). Confere as contagens, mostra as k
+// mais frequentes e mede a consulta de frequencia. Palavra vazia (so pontuacao) nao conta.
+void rodarFrequencias(const string& caminho, size_t k) {
+    ifstream arquivo(caminho);
+    if (!arquivo) {
+        cout << "nao consegui abrir " << caminho << endl;
+        return;
+    }
+    vector<string> palavras;
+    paraCadaPalavra(arquivo, [&](string&& limpa) {
+        if (!limpa.empty()) palavras.push_back(std::move(limpa));
+    });
+
+    auto inicio = chrono::steady_clock::now();
+    HashTable<string> conjunto(151, 2.0);
+    map<string, size_t> contagem;
+    for (const string& p : palavras) {
+        conjunto.insert(p);
+        contagem[p]++;
+    }
+    chrono::duration<double> tempoAntigo = chrono::steady_clock::now() - inicio;
+
+    inicio = chrono::steady_clock::now();
+    MapaHash<string, size_t> freq(151, 2.0);
+    for (const string& p : palavras) {
+        freq.increment(p);
+    }
+    chrono::duration<double> tempoMapa = chrono::steady_clock::now() - inicio;
+
+    bool ok = static_cast<size_t>(freq.length()) == contagem.size() && freq.conferirArvores();
+    inicio = chrono::steady_clock::now();
+    size_t soma = 0;
+    for (const auto& par : contagem) {
+        size_t n = freq.frequencia(par.first);
+        soma += n;
+        if (n != par.second) ok = false;
+    }
+    chrono::duration<double> tempoConsulta = chrono::steady_clock::now() - inicio;
+    if (freq.frequencia(string_view("###")) != 0) ok = false;
+
+    inicio = chrono::steady_clock::now();
+    vector<const EntradaMapa<string, size_t>*> top = freq.topK(k);
+    chrono::duration<double> tempoTop = chrono::steady_clock::now() - inicio;
+    // confere com a ordenacao completa do std::map
+    vector<pair<size_t, string>> todas;
+    for (const auto& par : contagem) todas.push_back({par.second, par.first});
+    sort(todas.begin(), todas.end(), [](const pair<size_t, string>& a, const pair<size_t, string>& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    if (top.size() != min(k, todas.size())) ok = false;
+    for (size_t i = 0; i < top.size() && ok; i++) {
+        if (top[i]->valor != todas[i].first || top[i]->chave != todas[i].second) ok = false;
+    }
+
+    cout << palavras.size() << " palavras, " << freq.length() << " distintas" << endl;
+    cout << "set + std::map (duas passadas): " << tempoAntigo.count() * 1e9 / palavras.size() << " ns por palavra" << endl;
+    cout << "increment (uma passada): " << tempoMapa.count() * 1e9 / palavras.size() << " ns por palavra" << endl;
+    cout << "frequencia: " << tempoConsulta.count() * 1e9 / contagem.size() << " ns por consulta" << endl;
+    cout << "top " << k << ": " << tempoTop.count() * 1000 << " ms" << endl;
+    for (const auto* e : top) {
+        cout << "  " << e->chave << ": " << e->valor << endl;
+    }
+    // carga em lote por cima das contagens: quem ja estava continua com o valor
+    if (!palavras.empty()) {
+        freq.bulkLoad(vector<std::string_view>{palavras[0], "palavraNovaDoLote"});
+        if (freq.frequencia(string_view("palavraNovaDoLote")) != 0 || !freq.conferirArvores()) ok = false;
+        for (const auto& par : contagem) {
+            if (freq.frequencia(par.first) != par.second) ok = false;
+        }
+    }
+    cout << (ok && soma == palavras.size() ? "contagens OK" : "contagens DIFERENTES") << endl;
+}
+
+// CONSULTA DE FAIXA: monta a tabela do texto (igual o fluxo padrao) e conta/lista as
+// palavras entre 'de' e 'ate' (fechado), ou que comecam com 'de' se nao tiver 'ate'.
+// Compara com a contagem na forca bruta (passando por todos os itens).
+void rodarFaixa(const string& caminho, const string& de, const string* ate) {
+    ifstream arquivo(caminho);
+    if (!arquivo) {
+        cout << "nao consegui abrir " << caminho << endl;
+        return;
+    }
+    HashTable<string> tabela;
+    paraCadaPalavra(arquivo, [&](string&& palavra) { tabela.insert(std::move(palavra)); });
+
+    auto dentro = [&](const string& p) {
+        return ate != nullptr ? de <= p && p <= *ate : p.compare(0, de.size(), de) == 0;
+    };
+    auto inicio = chrono::steady_clock::now();
+    size_t bruto = 0;
+    tabela.paraCada([&](const string& p) { bruto += dentro(p); });
+    chrono::duration<double> tempoBruto = chrono::steady_clock::now() - inicio;
+
+    const int REPETE = 100;
+    size_t total = 0;
+    inicio = chrono::steady_clock::now();
+    for (int r = 0; r < REPETE; r++) {
+        total = ate != nullptr ? tabela.countRange(de, *ate) : tabela.countPrefix(de);
+    }
+    chrono::duration<double> tempoContagem = (chrono::steady_clock::now() - inicio) / REPETE;
+
+    inicio = chrono::steady_clock::now();
+    vector<const string*> achadas = ate != nullptr ? tabela.faixa(de, *ate) : tabela.comPrefixo(de);
+    chrono::duration<double> tempoLista = chrono::steady_clock::now() - inicio;
+    bool ok = total == bruto && achadas.size() == bruto;
+    for (size_t i = 0; i < achadas.size() && ok; i++) {
+        if (!dentro(*achadas[i]) || (i > 0 && !(*achadas[i - 1] < *achadas[i]))) ok = false;
+    }
+
+    cout << tabela.length() << " palavras distintas em " << tabela.gavetas() << " gavetas" << endl;
+    if (ate != nullptr) cout << "entre \"" << de << "\" e \"" << *ate << "\": ";
+    else cout << "comecando com \"" << de << "\": ";
+    cout << total << (ok ? " (confere)" : " (DIFERENTE da forca bruta: " + to_string(bruto) + ")") << endl;
+    cout << "contagem: " << tempoContagem.count() * 1e6 << " us (forca bruta: " << tempoBruto.count() * 1e6 << " us)" << endl;
+    cout << "lista em ordem: " << tempoLista.count() * 1e6 << " us" << endl;
+    for (size_t i = 0; i < achadas.size() && i < 20; i++) {
+        cout << "  " << *achadas[i] << endl;
+    }
+    if (achadas.size() > 20) cout << "  ... (+" << achadas.size() - 20 << ")" << endl;
+}
+
+// EXPORTACAO EM ORDEM: monta a tabela do texto e tira a lista global ordenada pela
+// mescla das gavetas (sem passar pelo cout do CentralOrder). Mede chaves por segundo,
+// confere com o sort de todos os itens e, se tiver 'saida', grava uma por linha.
+void rodarExportar(const string& caminho, const char* saida) {
+    ifstream arquivo(caminho);
+    if (!arquivo) {
+        cout << "nao consegui abrir " << caminho << endl;
+        return;
+    }
+    HashTable<string> tabela; // 151 gavetas igual o fluxo padrao
+    paraCadaPalavra(arquivo, [&](string&& palavra) { tabela.insert(std::move(palavra)); });
+
+    // so andar: quanto custa a mescla em si
+    const int REPETE = 5;
+    size_t n = 0, bytes = 0;
+    auto inicio = chrono::steady_clock::now();
+    for (int r = 0; r < REPETE; r++) {
+        for (const string& p : tabela.ordenada()) {
+            bytes += p.size();
+            n++;
+        }
+    }
+    chrono::duration<double> tempo = (chrono::steady_clock::now() - inicio) / REPETE;
+    n /= REPETE;
+
+    // uma arvore sozinha: o iterador em ordem da BST
+    BST<string> arvore;
+    tabela.paraCada([&](const string& p) { arvore.Insert(p); });
+    inicio = chrono::steady_clock::now();
+    size_t m = 0;
+    for (int r = 0; r < REPETE; r++) {
+        for (const string& p : arvore) {
+            bytes += p.size();
+            m++;
+        }
+    }
+    chrono::duration<double> tempoArvore = (chrono::steady_clock::now() - inicio) / REPETE;
+    m /= REPETE;
+
+    vector<string_view> esperado;
+    tabela.paraCada([&](const string& p) { esperado.push_back(p); });
+    sort(esperado.begin(), esperado.end());
+    bool ok = esperado.size() == n && std::equal(esperado.begin(), esperado.end(), arvore.begin(), arvore.end());
+    size_t i = 0;
+    for (const string& p : tabela.ordenada()) {
+        if (i >= esperado.size() || esperado[i] != p) {
+            ok = false;
+            break;
+        }
+        i++;
+    }
+
+    if (saida != nullptr) {
+        ofstream out(saida);
+        for (const string& p : tabela.ordenada()) {
+            out << p << '\n';
+        }
+    }
+
+    cout << n << " chaves em " << tabela.gavetas() << " gavetas" << endl;
+    cout << "mescla das gavetas: " << tempo.count() * 1000 << " ms (" << n / tempo.count() / 1e6 << " M chaves/s)" << endl;
+    cout << "iterador de uma BST: " << tempoArvore.count() * 1000 << " ms (" << m / tempoArvore.count() / 1e6
+         << " M chaves/s)" << endl;
+    cout << "media de " << static_cast<double>(bytes) / max<size_t>(1, REPETE * (n + m)) << " letras por chave" << endl;
+    cout << (ok ? "ordem OK" : "ordem DIFERENTE") << endl;
+}
+
+// SNAPSHOT: salvar monta a tabela do texto (igual o fluxo padrao) e grava; consultar
+// abre o arquivo mapeado e roda o testador direto nele (sai igual ao fluxo padrao,
+// mais o tempo no fim); conferir faz a ida e volta e tenta abrir arquivos estragados.
+void rodarSalvarSnapshot(const string& texto, const string& caminho) {
+    ifstream arquivo(texto);
+    if (!arquivo) {
+        cout << "nao consegui abrir " << texto << endl;
+        return;
+    }
+    HashTable<string> tabela;
+    paraCadaPalavra(arquivo, [&](string&& palavra) { tabela.insert(std::move(palavra)); });
+    auto inicio = chrono::steady_clock::now();
+    bool ok = tabela.save(caminho);
+    chrono::duration<double> tempo = chrono::steady_clock::now() - inicio;
+    if (!ok) {
+        cout << "nao consegui gravar " << caminho << endl;
+        return;
+    }
+    cout << tabela.length() << " palavras gravadas em " << caminho << " (" << tempo.count() * 1000 << " ms)" << endl;
+}
+
+void rodarConsultarSnapshot(const string& caminho) {
+    auto inicio = chrono::steady_clock::now();
+    SnapshotTabela<> snapshot(caminho);
+    chrono::duration<double> tempo = chrono::steady_clock::now() - inicio;
+    if (!snapshot.valido()) {
+        cout << "snapshot invalido: " << snapshot.erro() << endl;
+        return;
+    }
+    testarAlturas(snapshot);
+    cout << endl << "snapshot aberto em " << tempo.count() * 1000 << " ms (" << snapshot.length() << " palavras, "
+         << snapshot.bytes() << " bytes, checksum conferido)" << endl;
+}
+
+bool rodarConferirSnapshot(const string& texto) {
+    ifstream arquivo(texto);
+    if (!arquivo) {
+        cout << "nao consegui abrir " << texto << endl;
+        return false;
+    }
+    vector<string> palavras = lerPalavras(arquivo);
+    // crescendo e parada no meio de um rehash: o save tem que terminar ele
+    HashTable<string> original(7, 2.0, 1);
+    for (const string& p : palavras) {
+        original.insert(p);
+    }
+    string caminho = "snapshot_conferencia.bin";
+    bool ok = true;
+    auto falhou = [&](const string& o_que) {
+        cout << "FALHOU: " << o_que << endl;
+        ok = false;
+    };
+
+    auto inicio = chrono::steady_clock::now();
+    if (!original.save(caminho)) falhou("save");
+    chrono::duration<double> tempoSave = chrono::steady_clock::now() - inicio;
+
+    HashTable<string> carregada;
+    inicio = chrono::steady_clock::now();
+    if (!carregada.load(caminho)) falhou("load");
+    chrono::duration<double> tempoLoad = chrono::steady_clock::now() - inicio;
+    if (!carregada.mesmaEstrutura(original)) falhou("load nao deu as mesmas arvores");
+    if (!carregada.conferirArvores()) falhou("arvores carregadas invalidas");
+
+    inicio = chrono::steady_clock::now();
+    SnapshotTabela<> mapeada(caminho);
+    chrono::duration<double> tempoAbrir = chrono::steady_clock::now() - inicio;
+    if (!mapeada.valido()) falhou(string("snapshot mapeado: ") + mapeada.erro());
+    if (ok) {
+        for (const string& p : palavras) {
+            if (!mapeada.search(p)) {
+                falhou("mapeado nao achou " + p);
+                break;
+            }
+        }
+        for (const string& p : palavras) {
+            string ausente = p + "#";
+            if (mapeada.search(ausente) != original.search(ausente)) {
+                falhou("mapeado achou " + ausente);
+                break;
+            }
+        }
+    }
+    // a tabela carregada continua viva: da pra inserir e remover
+    carregada.insert(string("palavraNovaDepoisDoLoad"));
+    carregada.remove(palavras.empty() ? string() : palavras[0]);
+    if (!carregada.conferirArvores()) falhou("mexer depois do load");
+
+    // estragado: cada um tem que ser recusado (pelo load e pelo mapeado)
+    string bom;
+    {
+        ifstream in(caminho, ios::binary);
+        bom.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+    auto recusado = [&](const string& conteudo, const string& nome) {
+        {
+            ofstream out(caminho, ios::binary | ios::trunc);
+            out.write(conteudo.data(), conteudo.size());
+        }
+        HashTable<string> t;
+        SnapshotTabela<> s(caminho);
+        if (t.load(caminho) || s.valido()) falhou("aceitou snapshot " + nome);
+        // recusado responde vazio (sem encostar nas partes que nao foram achadas)
+        string alguma = palavras.empty() ? string() : palavras[0];
+        if (s.gavetas() != 0 || s.length() != 0 || s.search(alguma) || s.buscarMostrarAltura(alguma) != -1) {
+            falhou("snapshot recusado " + nome + " ainda responde");
+        }
+    };
+    string estragado = bom;
+    estragado[estragado.size() / 2] ^= 0x20;
+    recusado(estragado, "com um bit trocado");
+    recusado(bom.substr(0, bom.size() - 8), "cortado");
+    recusado(bom.substr(0, 10), "curto demais");
+    estragado = bom;
+    estragado[8] = 99; // versao
+    recusado(estragado, "de outra versao");
+    // checksum certo mas forma errada: mexe num no da primeira gaveta com dois filhos
+    // e assina de novo
+    {
+        CabecalhoSnapshot cab;
+        memcpy(&cab, bom.data(), sizeof(cab));
+        size_t inicioNos = sizeof(CabecalhoSnapshot) + cab.gavetas * sizeof(GavetaSnapshot);
+        size_t raiz = cab.numNos;
+        for (size_t k = 0; k < cab.numNos && raiz == cab.numNos; k++) {
+            NoSnapshot no;
+            memcpy(&no, bom.data() + inicioNos + k * sizeof(NoSnapshot), sizeof(no));
+            if (no.esq != NENHUM_NO && no.dir != NENHUM_NO) raiz = k;
+        }
+        auto mexido = [&](auto mexer) {
+            string s = bom;
+            NoSnapshot pai;
+            NoSnapshot esq;
+            char* p = &s[inicioNos + raiz * sizeof(NoSnapshot)];
+            memcpy(&pai, p, sizeof(pai));
+            memcpy(&esq, p + sizeof(NoSnapshot), sizeof(esq));
+            mexer(pai, esq);
+            memcpy(p, &pai, sizeof(pai));
+            memcpy(p + sizeof(NoSnapshot), &esq, sizeof(esq));
+            uint64_t h = checksumSnapshot(0, s.data(), offsetof(CabecalhoSnapshot, checksum));
+            h = checksumSnapshot(h, s.data() + sizeof(CabecalhoSnapshot), s.size() - sizeof(CabecalhoSnapshot));
+            memcpy(&s[offsetof(CabecalhoSnapshot, checksum)], &h, sizeof(h));
+            return s;
+        };
+        if (raiz == cab.numNos) {
+            falhou("nenhum no com dois filhos pra estragar");
+        } else {
+            recusado(mexido([](NoSnapshot& pai, NoSnapshot&) { pai.dir = pai.esq; }), "com filho de dois pais");
+            recusado(mexido([](NoSnapshot& pai, NoSnapshot& esq) {
+                         std::swap(pai.texto, esq.texto);
+                         std::swap(pai.tamanho, esq.tamanho);
+                         std::swap(pai.prefixo, esq.prefixo);
+                     }),
+                     "com chaves fora de ordem");
+            recusado(mexido([](NoSnapshot& pai, NoSnapshot&) { pai.altura += 1; }), "com altura errada");
+        }
+    }
+    {
+        HashTable<string, HashFNV1a> outra;
+        std::ofstream(caminho, ios::binary | ios::trunc).write(bom.data(), bom.size());
+        if (outra.load(caminho)) falhou("aceitou snapshot de outra politica de hash");
+    }
+    std::remove(caminho.c_str());
+
+    cout << original.length() << " palavras, " << bom.size() << " bytes" << endl;
+    cout << "save: " << tempoSave.count() * 1000 << " ms, load: " << tempoLoad.count() * 1000
+         << " ms, abrir mapeado: " << tempoAbrir.count() * 1000 << " ms" << endl;
+    cout << (ok ? "OK" : "FALHOU") << endl;
+    return ok;
+}
+
+// INGESTAO EM FLUXO: le o texto em blocos de tamBloco bytes direto do arquivo (sem
+// carregar ele inteiro) e compara com a tabela do fluxo padrao. Com checkpoint, grava
+// base.snap/base.pos a cada 16 blocos e, se ja tiver um, continua de onde parou.
+void rodarIngestao(const string& texto, size_t tamBloco, const char* base) {
+    ifstream arquivo(texto, ios::binary);
+    if (!arquivo) {
+        cout << "nao consegui abrir " << texto << endl;
+        return;
+    }
+    HashTable<string> tabela;
+    IngestaoContinua<HashTable<string>> ingestao(tabela, tamBloco);
+    uint64_t offset = 0;
+    if (base != nullptr && IngestaoContinua<HashTable<string>>::retomar(tabela, base, offset)) {
+        cout << "retomando do byte " << offset << " (" << tabela.length() << " palavras no checkpoint)" << endl;
+        arquivo.seekg(static_cast<streamoff>(offset));
+        ingestao.comecarEm(offset);
+    }
+
+    auto inicio = chrono::steady_clock::now();
+    size_t blocos = 0;
+    while (ingestao.passo(arquivo)) {
+        if (base != nullptr && ++blocos % 16 == 0 && !ingestao.checkpoint(base)) {
+            cout << "nao consegui gravar o checkpoint " << base << endl;
+        }
+    }
+    if (base != nullptr) ingestao.checkpoint(base);
+    chrono::duration<double> tempo = chrono::steady_clock::now() - inicio;
+
+    // o fluxo padrao (palavra por palavra do ifstream) pra comparar
+    ifstream denovo(texto);
+    HashTable<string> padrao;
+    auto inicioPadrao = chrono::steady_clock::now();
+    paraCadaPalavra(denovo, [&](string&& palavra) { padrao.insert(std::move(palavra)); });
+    chrono::duration<double> tempoPadrao = chrono::steady_clock::now() - inicioPadrao;
+
+    cout << ingestao.palavrasLidas() << " palavras (" << tabela.length() << " distintas) ate o byte "
+         << ingestao.offset() << endl;
+    cout << "blocos de " << tamBloco << " bytes, buffer maximo: " << ingestao.bytesBuffer() << " bytes" << endl;
+    cout << "fluxo: " << tempo.count() * 1000 << " ms, padrao: " << tempoPadrao.count() * 1000 << " ms" << endl;
+    cout << "identica ao fluxo padrao: " << (tabela.mesmaEstrutura(padrao) ? "sim" : "NAO") << endl;
+}
+
+bool rodarConferirIngestao(const string& texto) {
+    ifstream arquivo(texto, ios::binary);
+    if (!arquivo) {
+        cout << "nao consegui abrir " << texto << endl;
+        return false;
+    }
+    string conteudo((istreambuf_iterator<char>(arquivo)), istreambuf_iterator<char>());
+    bool ok = true;
+    auto falhou = [&](const string& o_que) {
+        cout << "FALHOU: " << o_que << endl;
+        ok = false;
+    };
+    // referencia: o fluxo padrao, numa tabela fixa e numa que cresce
+    auto padrao = [&](HashTable<string>& t) {
+        istringstream in(conteudo);
+        paraCadaPalavra(in, [&](string&& palavra) { t.insert(std::move(palavra)); });
+    };
+    HashTable<string> fixa, crescendo(7, 2.0, 1);
+    padrao(fixa);
+    padrao(crescendo);
+
+    // blocos pequenos cortam quase toda palavra no meio; lote 1 e o insert de sempre
+    for (size_t bloco : {1, 3, 7, 64, 4096, 65536}) {
+        for (size_t lote : {1, 5, 4096}) {
+            HashTable<string> t, c(7, 2.0, 1);
+            istringstream in1(conteudo), in2(conteudo);
+            IngestaoContinua<HashTable<string>>(t, bloco, lote).consumir(in1);
+            IngestaoContinua<HashTable<string>>(c, bloco, lote).consumir(in2);
+            string nome = "bloco " + to_string(bloco) + " lote " + to_string(lote);
+            if (!t.mesmaEstrutura(fixa)) falhou(nome + ": tabela diferente do fluxo padrao");
+            if (!c.mesmaEstrutura(crescendo)) falhou(nome + " crescendo: tabela diferente do fluxo padrao");
+        }
+    }
+
+    // cai no meio (depois de alguns blocos, com checkpoint) e continua do offset
+    string base = "ingestao_conferencia";
+    for (size_t paraEm : {1, 5, 40}) {
+        {
+            HashTable<string> t;
+            istringstream in(conteudo);
+            IngestaoContinua<HashTable<string>> ingestao(t, 97);
+            for (size_t i = 0; i < paraEm && ingestao.passo(in); i++) {
+            }
+            if (!ingestao.checkpoint(base)) falhou("checkpoint");
+            // e mais um pouco que se perde (nao entrou no checkpoint)
+            ingestao.passo(in);
+        }
+        HashTable<string> retomada;
+        uint64_t offset = 0;
+        if (!IngestaoContinua<HashTable<string>>::retomar(retomada, base, offset)) {
+            falhou("retomar");
+            continue;
+        }
+        istringstream in(conteudo);
+        in.seekg(static_cast<streamoff>(offset));
+        IngestaoContinua<HashTable<string>> ingestao(retomada, 97);
+        ingestao.comecarEm(offset);
+        ingestao.consumir(in);
+        if (!retomada.mesmaEstrutura(fixa)) {
+            falhou("retomado do checkpoint depois de " + to_string(paraEm) + " blocos: tabela diferente");
+        }
+    }
+    std::remove((base + ".snap").c_str());
+    std::remove((base + ".pos").c_str());
+
+    // sem checkpoint nao mexe na tabela
+    HashTable<string> vazia;
+    uint64_t offset = 0;
+    if (IngestaoContinua<HashTable<string>>::retomar(vazia, base, offset) || vazia.length() != 0) {
+        falhou("retomou sem checkpoint");
+    }
+
+    cout << fixa.length() << " palavras distintas" << endl;
+    cout << (ok ? "OK" : "FALHOU") << endl;
+    return ok;
+}
+
+// DIARIO: o bench insere as n primeiras palavras sem diario e com diario em varios
+// intervalos de fsync; conferir mistura inserts e removes com compactacoes no meio e
+// recupera do disco (inclusive com escrita cortada no fim e com segmento estragado).
+// o lerPalavras direto do caminho (arquivo que nao abre = nenhuma palavra)
+vector<string> lerPalavrasLimpas(const string& texto, size_t limite) {
+    ifstream arquivo(texto);
+    return lerPalavras(arquivo, limite);
+}
+
+void apagarDiario(const string& base) {
+    std::remove((base + ".snap").c_str());
+    std::remove((base + ".manifesto").c_str());
+    for (int n = 0; n < 256; n++) {
+        std::remove((base + "." + to_string(n) + ".wal").c_str());
+    }
+}
+
+void rodarBenchDiario(const string& texto, size_t limite) {
+    vector<string> palavras = lerPalavrasLimpas(texto, limite);
+    if (palavras.empty()) {
+        cout << "nao consegui ler " << texto << endl;
+        return;
+    }
+    string base = "bench_diario";
+    size_t n = palavras.size();
+    auto linha = [&](const string& nome, chrono::duration<double> tempo, size_t fsyncs, uint64_t bytes) {
+        cout << nome << ": " << tempo.count() * 1000 << " ms, " << n / tempo.count() / 1e3 << " mil ops/s, "
+             << fsyncs << " fsyncs, " << bytes << " bytes no diario" << endl;
+    };
+    cout << n << " inserts" << endl;
+    {
+        HashTable<string> t;
+        auto inicio = chrono::steady_clock::now();
+        for (const string& p : palavras) t.insert(std::string_view(p));
+        linha("sem diario", chrono::steady_clock::now() - inicio, 0, 0);
+    }
+    // 0 = sem fsync por operacao (so um no fim)
+    for (size_t intervalo : {0, 4096, 256, 16, 1}) {
+        apagarDiario(base);
+        HashTable<string> t;
+        DiarioTabela<HashTable<string>> diario(t, base, intervalo);
+        if (!diario.abrir()) {
+            cout << "nao consegui abrir o diario" << endl;
+            return;
+        }
+        auto inicio = chrono::steady_clock::now();
+        bool gravou = true;
+        for (const string& p : palavras) gravou = gravou && diario.insert(p);
+        gravou = gravou && diario.sincronizar();
+        chrono::duration<double> tempo = chrono::steady_clock::now() - inicio;
+        if (!gravou) {
+            cout << "nao consegui gravar o diario" << endl;
+            break;
+        }
+        linha(intervalo == 0 ? string("diario, fsync so no fim") : "diario, fsync a cada " + to_string(intervalo),
+              tempo, diario.numFsyncs(), diario.bytes());
+    }
+    apagarDiario(base);
+}
+
+bool rodarConferirDiario(const string& texto) {
+    vector<string> palavras = lerPalavrasLimpas(texto, SIZE_MAX);
+    string base = "diario_conferencia";
+    apagarDiario(base);
+    bool ok = true;
+    auto falhou = [&](const string& o_que) {
+        cout << "FALHOU: " << o_que << endl;
+        ok = false;
+    };
+    // operacao i: insere a palavra i e, de 5 em 5, tira a palavra i/2
+    auto aplicar = [&](size_t i, auto&& inserir, auto&& remover) {
+        inserir(palavras[i]);
+        if (i % 5 == 4) remover(palavras[i / 2]);
+    };
+    HashTable<string> esperada;
+    for (size_t i = 0; i < palavras.size(); i++) {
+        aplicar(i, [&](const string& p) { esperada.insert(p); }, [&](const string& p) { esperada.remove(p); });
+    }
+
+    {
+        HashTable<string> t;
+        DiarioTabela<HashTable<string>> diario(t, base, 64);
+        bool gravou = true;
+        if (!diario.abrir()) falhou("abrir vazio");
+        size_t terco = palavras.size() / 3;
+        for (size_t i = 0; i < palavras.size(); i++) {
+            if (i == terco || i == 2 * terco) {
+                if (!diario.compactar()) { // a anterior ainda rodando: espera e tenta de novo
+                    diario.esperarCompactacao();
+                    if (!diario.compactar()) falhou("compactar");
+                }
+            }
+            aplicar(i, [&](const string& p) { gravou = diario.insert(p) && gravou; },
+                    [&](const string& p) { gravou = diario.remove(p) && gravou; });
+        }
+        if (!gravou) falhou("gravar no diario");
+        if (!diario.esperarCompactacao()) falhou("compactacao em segundo plano");
+        if (!t.mesmaEstrutura(esperada)) falhou("tabela com diario diferente");
+    } // o destrutor sincroniza o que faltou
+
+    size_t refeitas = 0;
+    uint64_t ultimo = 0;
+    {
+        HashTable<string> recuperada;
+        DiarioTabela<HashTable<string>> diario(recuperada, base, 64);
+        if (!diario.abrir(&refeitas)) falhou("recuperar");
+        if (!recuperada.mesmaEstrutura(esperada)) falhou("recuperada diferente");
+        if (diario.primeiroSegmento() == 0) falhou("manifesto nao andou com a compactacao");
+        ultimo = diario.segmentoAtual();
+    }
+
+    // escrita cortada no fim do ultimo segmento: um registro pela metade e um com
+    // checksum errado ficam de fora e o arquivo e cortado de volta
+    string ultimoSegmento = base + "." + to_string(ultimo) + ".wal";
+    {
+        std::ofstream out(ultimoSegmento, ios::binary | ios::app);
+        char lixo[CABECALHO_REGISTRO + 3] = {1, 2, 3, 4, REGISTRO_INSERIR, 3, 0, 0, 0, 'a', 'b', 'c'};
+        out.write(lixo, sizeof(lixo)); // checksum errado
+        out.write(lixo, 6);            // pela metade
+    }
+    {
+        HashTable<string> recuperada;
+        DiarioTabela<HashTable<string>> diario(recuperada, base, 64);
+        if (!diario.abrir()) falhou("recuperar com escrita cortada");
+        if (!recuperada.mesmaEstrutura(esperada)) falhou("recuperada com escrita cortada diferente");
+        ultimo = diario.segmentoAtual();
+        if (!diario.insert("depoisDaRecuperacao")) falhou("insert depois de recuperar");
+    }
+    {
+        HashTable<string> recuperada;
+        DiarioTabela<HashTable<string>> diario(recuperada, base, 64);
+        if (!diario.abrir() || !recuperada.search(string("depoisDaRecuperacao"))) {
+            falhou("insert depois de recuperar sumiu");
+        }
+    }
+
+    // estrago no meio (tem segmento depois dele): nao da pra continuar
+    {
+        string caminho = base + "." + to_string(ultimo) + ".wal";
+        string conteudo;
+        {
+            ifstream in(caminho, ios::binary);
+            conteudo.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+        }
+        conteudo[CABECALHO_DIARIO] ^= 0x40;
+        std::ofstream(caminho, ios::binary | ios::trunc).write(conteudo.data(), conteudo.size());
+        HashTable<string> recuperada;
+        DiarioTabela<HashTable<string>> diario(recuperada, base, 64);
+        if (diario.abrir()) falhou("aceitou segmento estragado no meio");
+    }
+    apagarDiario(base);
+
+#ifdef TEM_MMAP
+    // disco cheio: limite de tamanho de arquivo logo depois do cabecalho (o write
+    // devolve EFBIG em vez de matar o processo com SIGXFSZ). O insert que nao coube
+    // tem que ser recusado sem mexer na tabela, os seguintes tambem, e recuperar tem
+    // que dar exatamente o que foi aceito.
+    {
+        HashTable<string> t;
+        DiarioTabela<HashTable<string>> diario(t, base, 1);
+        struct rlimit antes;
+        getrlimit(RLIMIT_FSIZE, &antes);
+        auto sinalAntes = std::signal(SIGXFSZ, SIG_IGN);
+        size_t aceitas = 0;
+        if (!diario.abrir()) {
+            falhou("abrir pro disco cheio");
+        } else {
+            struct rlimit limite = antes;
+            limite.rlim_cur = CABECALHO_DIARIO + 200;
+            setrlimit(RLIMIT_FSIZE, &limite);
+            for (const string& p : palavras) {
+                if (!diario.insert(p)) break;
+                aceitas++;
+            }
+            int antesDaRecusa = t.length();
+            if (!diario.comErro() || aceitas == palavras.size()) falhou("disco cheio nao foi percebido");
+            if (diario.insert("depoisDoErro") || diario.remove(palavras[0]) || diario.sincronizar()) {
+                falhou("diario com erro aceitou operacao");
+            }
+            if (t.length() != antesDaRecusa || t.search(string("depoisDoErro"))) falhou("operacao recusada mexeu na tabela");
+            setrlimit(RLIMIT_FSIZE, &antes);
+        }
+        std::signal(SIGXFSZ, sinalAntes);
+
+        HashTable<string> aceita;
+        for (size_t i = 0; i < aceitas; i++) aceita.insert(palavras[i]);
+        HashTable<string> recuperada;
+        DiarioTabela<HashTable<string>> denovo(recuperada, base, 1);
+        if (!denovo.abrir() || !recuperada.mesmaEstrutura(aceita)) falhou("recuperar depois do disco cheio");
+    }
+    apagarDiario(base);
+#endif
+
+    cout << palavras.size() << " palavras, " << esperada.length() << " na tabela no fim, " << refeitas
+         << " operacoes refeitas do diario depois do snapshot" << endl;
+    cout << (ok ? "OK" : "FALHOU") << endl;
+    return ok;
 }
 
-template<typename T>
-// peguei exatamet a funcao da outra vez
-size_t HashTable<T>::Hash(const T& key) {
-    size_t hashValue = 0;
-    size_t n = key.length();
-    for (size_t i = 0; i < n; ++i) {
-        hashValue += key[i] * static_cast<size_t>(std::pow(128, n - i - 1));
-        hashValue %= SIZE; // Aplica o módulo a cada iteração
+// SUITE DE BENCHMARK: as operacoes da tabela (insert, busca que acha, busca que nao
+// acha, remove, bulkLoad, destruir) e a List do fluxo padrao, em quatro distribuicoes
+// de chave: o texto, uniforme, Zipf e todas na mesma gaveta (pior caso do HashLegado).
+// As geradas saem de um mt19937_64 com semente fixa, entao toda rodada usa as mesmas
+// chaves. ns/op e ops/s vem de um laco sem relogio no meio; os percentis vem de outra
+// passada medindo operacao por operacao (inclui o custo de ler o relogio, que tambem
+// sai no relatorio). Pico de RSS por operacao (zerado antes de cada uma quando o
+// /proc deixa). Sai uma tabela na tela e o JSON no arquivo, pra comparar entre commits.
+const uint64_t SEMENTE_SUITE = 20240917;
+
+// zera o pico de memoria do processo (Linux: clear_refs 5); false = nao da
+inline bool zerarPicoRSS() {
+    std::ofstream limpar("/proc/self/clear_refs");
+    return static_cast<bool>(limpar << "5" << std::flush);
+}
+
+// pico de memoria residente em kB (0 se nao souber)
+inline size_t picoRSS() {
+    ifstream status("/proc/self/status");
+    string linha;
+    while (getline(status, linha)) {
+        if (linha.compare(0, 6, "VmHWM:") == 0) return strtoul(linha.c_str() + 6, nullptr, 10);
     }
-    return hashValue;
+#ifdef TEM_MMAP
+    struct rusage uso;
+    if (getrusage(RUSAGE_SELF, &uso) == 0) return static_cast<size_t>(uso.ru_maxrss);
+#endif
+    return 0;
 }
 
-template<typename T>
-void HashTable<T>::insert(T item) {
-    int indice = Hash(item);
-    // garantindo que existe kkk
-    if (tabela[indice] == nullptr) {
-        tabela[indice] = new BST<T>();
+struct CargaSuite {
+    string nome;
+    vector<string> chaves;   // na ordem de insercao (pode repetir)
+    vector<string> acertos;  // distintas embaralhadas
+    vector<string> erros;    // nenhuma foi inserida
+};
+
+struct ResultadoSuite {
+    string carga;
+    string operacao;
+    size_t ops = 0;
+    double nsPorOp = 0;
+    double p50 = 0, p90 = 0, p99 = 0, p999 = 0, maximo = 0;
+    size_t amostras = 0; // de quantas medidas sairam os percentis
+    size_t rssKb = 0;
+};
+
+// o percentil p so diz algo se sobrar pelo menos uma amostra acima dele (com 5 rodadas
+// o p90, o p99 e o p99.9 seriam so o maximo de novo)
+inline bool temPercentil(const ResultadoSuite& r, double p) {
+    return static_cast<double>(r.amostras) * (1.0 - p) >= 1.0 - 1e-9;
+}
+
+// 'quantas' palavras distintas de a-z com 3 a 12 letras; aceitar filtra (mesma gaveta)
+template <typename F>
+vector<string> gerarChaves(mt19937_64& gerador, size_t quantas, F aceitar) {
+    vector<string> chaves;
+    while (chaves.size() < quantas) {
+        while (chaves.size() < quantas + quantas / 8 + 16) {
+            string chave(3 + gerador() % 10, 'a');
+            for (char& c : chave) c = static_cast<char>('a' + gerador() % 26);
+            if (aceitar(chave)) chaves.push_back(std::move(chave));
+        }
+        sort(chaves.begin(), chaves.end());
+        chaves.erase(unique(chaves.begin(), chaves.end()), chaves.end());
     }
+    shuffle(chaves.begin(), chaves.end(), gerador);
+    chaves.resize(quantas);
+    return chaves;
+}
 
-    tabela[indice]->Insert(item);
+// universo de u chaves + as de erro (geradas juntas, entao nunca colidem com as inseridas)
+template <typename F>
+CargaSuite montarCargaGerada(const string& nome, size_t n, size_t u, F sortear, mt19937_64& gerador,
+                             bool mesmaGaveta) {
+    HashLegado legado;
+    vector<string> todas = gerarChaves(gerador, u + u / 2, [&](const string& chave) {
+        return !mesmaGaveta || legado(chave, 151) == 0;
+    });
+    CargaSuite carga;
+    carga.nome = nome;
+    carga.erros.assign(todas.begin() + u, todas.end());
+    todas.resize(u);
+    carga.chaves.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        carga.chaves.push_back(todas[sortear(gerador)]);
+    }
+    carga.acertos = carga.chaves;
+    sort(carga.acertos.begin(), carga.acertos.end());
+    carga.acertos.erase(unique(carga.acertos.begin(), carga.acertos.end()), carga.acertos.end());
+    shuffle(carga.acertos.begin(), carga.acertos.end(), gerador);
+    return carga;
 }
 
-template<typename T>
-void HashTable<T>::remove(T item) {
-    int indice = Hash(item);
+vector<CargaSuite> montarCargasSuite(const string& texto, size_t n) {
+    vector<CargaSuite> cargas;
+    mt19937_64 gerador(SEMENTE_SUITE);
+
+    CargaSuite base;
+    base.nome = "texto";
+    base.chaves = lerPalavrasLimpas(texto, SIZE_MAX);
+    base.acertos = base.chaves;
+    sort(base.acertos.begin(), base.acertos.end());
+    base.acertos.erase(unique(base.acertos.begin(), base.acertos.end()), base.acertos.end());
+    for (const string& p : base.acertos) base.erros.push_back(p + "~");
+    shuffle(base.acertos.begin(), base.acertos.end(), gerador);
+    if (!base.chaves.empty()) cargas.push_back(std::move(base));
+
+    const size_t u = max<size_t>(1, n / 4);
+    cargas.push_back(montarCargaGerada("uniforme", n, u, [&](mt19937_64& g) { return g() % u; }, gerador, false));
+
+    // Zipf com s = 1: a chave de posicao k sai com peso 1/(k+1)
+    vector<double> acumulada(u);
+    double soma = 0;
+    for (size_t k = 0; k < u; k++) {
+        soma += 1.0 / static_cast<double>(k + 1);
+        acumulada[k] = soma;
+    }
+    std::uniform_real_distribution<double> sorteio(0.0, soma);
+    cargas.push_back(montarCargaGerada("zipf", n, u, [&](mt19937_64& g) {
+        size_t k = lower_bound(acumulada.begin(), acumulada.end(), sorteio(g)) - acumulada.begin();
+        return min(k, u - 1);
+    }, gerador, false));
+
+    // todas na gaveta 0 das 151 (universo menor: gerar ja custa 151 tentativas por chave)
+    const size_t uMesma = max<size_t>(1, min<size_t>(u, 20000));
+    cargas.push_back(montarCargaGerada("mesma-gaveta", n, uMesma, [&](mt19937_64& g) { return g() % uMesma; },
+                                       gerador, true));
+    return cargas;
+}
 
-    if (tabela[indice] == nullptr) {
-        return;
+// custo de ler o relogio duas vezes (o que os percentis tem a mais)
+inline double custoRelogio() {
+    vector<uint32_t> amostras(100000);
+    for (uint32_t& a : amostras) {
+        auto antes = chrono::steady_clock::now();
+        auto depois = chrono::steady_clock::now();
+        a = static_cast<uint32_t>(chrono::duration_cast<chrono::nanoseconds>(depois - antes).count());
     }
+    std::nth_element(amostras.begin(), amostras.begin() + amostras.size() / 2, amostras.end());
+    return amostras[amostras.size() / 2];
+}
 
-    tabela[Hash(item)]->Remove(item);
+// total sem relogio no meio + percentis de uma passada operacao por operacao
+template <typename Preparar, typename Operar>
+ResultadoSuite medirOperacaoSuite(const string& carga, const string& operacao, size_t n, Preparar preparar,
+                                  Operar operar) {
+    ResultadoSuite r;
+    r.carga = carga;
+    r.operacao = operacao;
+    r.ops = n;
+    zerarPicoRSS();
+    preparar();
+    auto inicio = chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++) operar(i);
+    chrono::duration<double, std::nano> total = chrono::steady_clock::now() - inicio;
+    r.nsPorOp = n > 0 ? total.count() / n : 0;
+
+    preparar();
+    vector<uint32_t> amostras(n);
+    for (size_t i = 0; i < n; i++) {
+        auto antes = chrono::steady_clock::now();
+        operar(i);
+        auto depois = chrono::steady_clock::now();
+        amostras[i] = static_cast<uint32_t>(chrono::duration_cast<chrono::nanoseconds>(depois - antes).count());
+    }
+    r.rssKb = picoRSS();
+    r.amostras = n;
+    if (n > 0) {
+        sort(amostras.begin(), amostras.end());
+        auto percentil = [&](double p) { return static_cast<double>(amostras[static_cast<size_t>(p * (n - 1))]); };
+        r.p50 = percentil(0.5);
+        r.p90 = percentil(0.9);
+        r.p99 = percentil(0.99);
+        r.p999 = percentil(0.999);
+        r.maximo = amostras.back();
+    }
+    return r;
 }
 
-template<typename T>
-bool HashTable<T>::search(T item) {
-    int indice = Hash(item);
+// bulkLoad e destruir sao uma operacao so sobre a tabela inteira: repete e mede cada
+// rodada; os percentis sao das rodadas, em ns por chave
+ResultadoSuite medirRodadasSuite(const string& carga, const string& operacao, size_t porRodada,
+                                 const vector<double>& rodadas, size_t rssKb) {
+    ResultadoSuite r;
+    r.carga = carga;
+    r.operacao = operacao;
+    r.ops = porRodada * rodadas.size();
+    r.rssKb = rssKb;
+    if (r.ops == 0) {
+        return r; // carga vazia: nada por chave pra medir
+    }
+    vector<double> porChave;
+    for (double ns : rodadas) porChave.push_back(ns / porRodada);
+    sort(porChave.begin(), porChave.end());
+    double soma = 0;
+    for (double v : porChave) soma += v;
+    r.nsPorOp = soma / porChave.size();
+    auto percentil = [&](double p) { return porChave[static_cast<size_t>(p * (porChave.size() - 1))]; };
+    r.p50 = percentil(0.5);
+    r.p90 = percentil(0.9);
+    r.p99 = percentil(0.99);
+    r.p999 = percentil(0.999);
+    r.maximo = porChave.back();
+    r.amostras = porChave.size();
+    return r;
+}
+
+vector<ResultadoSuite> rodarCargaSuite(const CargaSuite& carga) {
+    vector<ResultadoSuite> resultados;
+    std::unique_ptr<HashTable<string>> tabela;
+    auto nova = [&] { tabela.reset(new HashTable<string>()); };
+    auto cheia = [&] {
+        nova();
+        for (const string& k : carga.chaves) tabela->insert(std::string_view(k));
+    };
+    size_t achados = 0;
+
+    resultados.push_back(medirOperacaoSuite(carga.nome, "insert", carga.chaves.size(), nova,
+                                            [&](size_t i) { tabela->insert(std::string_view(carga.chaves[i])); }));
+    resultados.push_back(medirOperacaoSuite(carga.nome, "busca-acerto", carga.acertos.size(), [] {},
+                                            [&](size_t i) { achados += tabela->search(carga.acertos[i]); }));
+    resultados.push_back(medirOperacaoSuite(carga.nome, "busca-erro", carga.erros.size(), [] {},
+                                            [&](size_t i) { achados += tabela->search(carga.erros[i]); }));
+    resultados.push_back(medirOperacaoSuite(carga.nome, "remove", carga.acertos.size(), cheia,
+                                            [&](size_t i) { tabela->remove(carga.acertos[i]); }));
+    if (tabela->length() != 0 || achados != 2 * carga.acertos.size()) {
+        cout << "  " << carga.nome << ": resultados ERRADOS (" << achados << " achados, " << tabela->length()
+             << " sobrando)" << endl;
+    }
+
+    // bulkLoad e destruir: 5 rodadas
+    vector<double> tempoBulk, tempoDestroi;
+    zerarPicoRSS();
+    for (int r = 0; r < 5; r++) {
+        nova();
+        auto inicio = chrono::steady_clock::now();
+        tabela->bulkLoad(carga.chaves);
+        tempoBulk.push_back(chrono::duration<double, std::nano>(chrono::steady_clock::now() - inicio).count());
+        inicio = chrono::steady_clock::now();
+        tabela.reset();
+        tempoDestroi.push_back(chrono::duration<double, std::nano>(chrono::steady_clock::now() - inicio).count());
+    }
+    size_t rss = picoRSS();
+    resultados.push_back(medirRodadasSuite(carga.nome, "bulk", carga.chaves.size(), tempoBulk, rss));
+    resultados.push_back(medirRodadasSuite(carga.nome, "destruir", carga.acertos.size(), tempoDestroi, rss));
+
+    // a fase da List do fluxo padrao: insertBack de tudo e depois popFront de tudo
+    List<string> lista;
+    const size_t n = carga.chaves.size();
+    resultados.push_back(medirOperacaoSuite(carga.nome, "lista", 2 * n, [] {}, [&](size_t i) {
+        if (i < n) {
+            lista.insertBack(carga.chaves[i]);
+        } else {
+            lista.popFront();
+        }
+    }));
+    return resultados;
+}
+
+void rodarSuite(const string& texto, const string& saida, size_t n) {
+    auto inicio = chrono::steady_clock::now();
+    vector<CargaSuite> cargas = montarCargasSuite(texto, n);
+    chrono::duration<double> tempoGerar = chrono::steady_clock::now() - inicio;
+    double relogio = custoRelogio();
+    bool temPico = zerarPicoRSS();
+    cout << "semente " << SEMENTE_SUITE << ", chaves geradas em " << tempoGerar.count() * 1000
+         << " ms, relogio " << relogio << " ns" << (temPico ? "" : " (pico de RSS e do processo todo)") << endl;
+
+    vector<ResultadoSuite> resultados;
+    for (const CargaSuite& carga : cargas) {
+        cout << endl << carga.nome << ": " << carga.chaves.size() << " chaves, " << carga.acertos.size()
+             << " distintas" << endl;
+        for (const ResultadoSuite& r : rodarCargaSuite(carga)) {
+            // '-' = nao deu pra medir (nenhuma operacao, ou amostra de menos pro percentil)
+            auto valor = [](bool tem, double v) {
+                ostringstream out;
+                if (tem) {
+                    out << v;
+                } else {
+                    out << '-';
+                }
+                return out.str();
+            };
+            cout << "  " << r.operacao << ": " << r.nsPorOp << " ns/op, " << valor(r.nsPorOp > 0, 1e3 / r.nsPorOp)
+                 << " M ops/s | p50 " << valor(temPercentil(r, 0.5), r.p50) << " p90 "
+                 << valor(temPercentil(r, 0.9), r.p90) << " p99 " << valor(temPercentil(r, 0.99), r.p99)
+                 << " p99.9 " << valor(temPercentil(r, 0.999), r.p999) << " max " << valor(r.amostras > 0, r.maximo)
+                 << " ns | pico " << r.rssKb << " kB" << endl;
+            resultados.push_back(r);
+        }
+    }
+
+    ofstream json(saida);
+    json << "{\n  \"semente\": " << SEMENTE_SUITE << ",\n  \"gavetas\": 151,\n  \"politica\": \"" << HashLegado::nome
+         << "\",\n  \"ns_relogio\": " << relogio << ",\n  \"resultados\": [\n";
+    // o que nao deu pra medir sai null (inf ou percentil repetido nao servem pra ninguem)
+    auto campo = [&](const char* nome, bool tem, double v) {
+        json << ", \"" << nome << "\": ";
+        if (tem) {
+            json << v;
+        } else {
+            json << "null";
+        }
+    };
+    for (size_t i = 0; i < resultados.size(); i++) {
+        const ResultadoSuite& r = resultados[i];
+        json << "    {\"carga\": \"" << r.carga << "\", \"operacao\": \"" << r.operacao << "\", \"ops\": " << r.ops
+             << ", \"ns_por_op\": " << r.nsPorOp;
+        campo("ops_por_s", r.nsPorOp > 0, 1e9 / r.nsPorOp);
+        campo("p50_ns", temPercentil(r, 0.5), r.p50);
+        campo("p90_ns", temPercentil(r, 0.9), r.p90);
+        campo("p99_ns", temPercentil(r, 0.99), r.p99);
+        campo("p999_ns", temPercentil(r, 0.999), r.p999);
+        campo("max_ns", r.amostras > 0, r.maximo);
+        json << ", \"pico_rss_kb\": " << r.rssKb << "}" << (i + 1 < resultados.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+    cout << endl << (json ? "JSON em " + saida : "nao consegui gravar " + saida) << endl;
+}
 
-    if (tabela[indice] == nullptr) {
+// ESTATISTICAS: monta a tabela do texto (com crescimento, pra passar pela migracao),
+// busca tudo que entrou e mais as que nao existem, remove uma em cada dez, e no fim
+// imprime o export (json ou prometheus). Enquanto isso outra thread fica exportando
+// sem parar a tabela. So faz algo compilado com -DCOM_ESTATISTICAS.
+bool rodarEstatisticas(const string& texto, const string& formato) {
+#ifdef COM_ESTATISTICAS
+    vector<string> palavras = lerPalavrasLimpas(texto, SIZE_MAX);
+    if (palavras.empty()) {
+        cout << "nao consegui ler " << texto << endl;
         return false;
     }
+    HashTable<string> tabela(31, 4.0);
+    std::atomic<bool> parar{false};
+    size_t exportes = 0;
+    std::thread exportador([&] {
+        while (!parar.load()) {
+            ostringstream out;
+            if (formato == "prometheus") tabela.estatisticas().prometheus(out);
+            else tabela.estatisticas().json(out);
+            exportes++;
+        }
+    });
+    for (const string& p : palavras) tabela.insert(std::string_view(p));
+    for (const string& p : palavras) tabela.search(p);
+    for (const string& p : palavras) tabela.search(p + "~");
+    for (size_t i = 0; i < palavras.size(); i += 10) tabela.remove(palavras[i]);
+    parar = true;
+    exportador.join();
+    // termina a migracao (cada busca anda um pouco) antes de conferir as gavetas
+    for (size_t i = 0; i < tabela.gavetas(); i++) tabela.search(string());
+
+    if (formato == "prometheus") tabela.estatisticas().prometheus(cout);
+    else tabela.estatisticas().json(cout);
+    bool gavetasOk = tabela.conferirEstatisticas() && tabela.conferirArvores();
+
+    // insertMany/searchMany contam igual ao um por um: mesma carga nos dois jeitos, em
+    // tabelas fixas (o insertMany so agrupa por gaveta sem crescimento), e os
+    // histogramas tem que ter uma amostra por operacao
+    HashTable<string> emLote(151), umPorUm(151);
+    vector<std::string_view> inserir(palavras.begin(), palavras.end());
+    vector<string> ausentes;
+    for (const string& p : palavras) ausentes.push_back(p + "~");
+    vector<std::string_view> consultas = inserir;
+    consultas.insert(consultas.end(), ausentes.begin(), ausentes.end());
+    std::unique_ptr<bool[]> achou(new bool[consultas.size()]);
+    const size_t LOTE = 256;
+    for (size_t i = 0; i < inserir.size(); i += LOTE) {
+        emLote.insertMany(inserir.data() + i, min(LOTE, inserir.size() - i));
+    }
+    for (size_t i = 0; i < consultas.size(); i += LOTE) {
+        emLote.searchMany(consultas.data() + i, min(LOTE, consultas.size() - i), achou.get() + i);
+    }
+    for (std::string_view p : inserir) umPorUm.insert(p);
+    for (std::string_view p : consultas) umPorUm.search(p);
+    const EstatisticasTabela& a = emLote.estatisticas();
+    const EstatisticasTabela& b = umPorUm.estatisticas();
+    auto igual = [](const std::atomic<uint64_t>& x, const std::atomic<uint64_t>& y) { return x.load() == y.load(); };
+    uint64_t amostrasInsert = 0;
+    uint64_t amostrasBusca = 0;
+    a.latInsert.copiar(amostrasInsert);
+    a.latBusca.copiar(amostrasBusca);
+    bool lotesOk = igual(a.inserts, b.inserts) && igual(a.insertsNovos, b.insertsNovos) && igual(a.buscas, b.buscas) &&
+                   igual(a.buscasAchadas, b.buscasAchadas) && igual(a.sondagens, b.sondagens) &&
+                   amostrasInsert == a.inserts.load() && amostrasBusca == a.buscas.load() &&
+                   emLote.conferirEstatisticas();
+    cerr << exportes << " exports no meio do trabalho; gavetas e profundidades conferidas: "
+         << (gavetasOk ? "sim" : "NAO") << "; lotes contados igual: " << (lotesOk ? "sim" : "NAO") << endl;
+    return gavetasOk && lotesOk;
+#else
+    (void)texto;
+    (void)formato;
+    cout << "estatisticas desligadas: compile com -DCOM_ESTATISTICAS" << endl;
+    return true;
+#endif
+}
+
+// CONFERENCIA DE COPIAS: uma palavra que conta quantas vezes foi copiada/movida e
+// quantas vezes o texto dela foi pro heap (alocador contado). Serve pra conferir que
+// do cin ate o no da arvore cada palavra e montada uma vez so (so movida no caminho)
+struct ContagemCopias {
+    static inline size_t copias = 0;
+    static inline size_t movidas = 0;
+    static inline size_t alocacoes = 0;
+    static void zerar() { copias = movidas = alocacoes = 0; }
+};
+
+template <typename C>
+struct AlocadorContado {
+    typedef C value_type;
+    AlocadorContado() = default;
+    template <typename U>
+    AlocadorContado(const AlocadorContado<U>&) {}
+    C* allocate(size_t n) {
+        ContagemCopias::alocacoes++;
+        return std::allocator<C>().allocate(n);
+    }
+    void deallocate(C* p, size_t n) { std::allocator<C>().deallocate(p, n); }
+    template <typename U>
+    bool operator==(const AlocadorContado<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlocadorContado<U>&) const { return false; }
+};
 
-    BSTNode<T>* temp = tabela[Hash(item)]->Search(item);
+typedef std::basic_string<char, std::char_traits<char>, AlocadorContado<char>> TextoContado;
 
-    if (temp == nullptr) {
+struct PalavraContada {
+    TextoContado texto;
+
+    PalavraContada() = default;
+    explicit PalavraContada(std::string_view s) : texto(s.data(), s.size()) {}
+    PalavraContada(const PalavraContada& outra) : texto(outra.texto) { ContagemCopias::copias++; }
+    PalavraContada(PalavraContada&& outra) noexcept : texto(std::move(outra.texto)) { ContagemCopias::movidas++; }
+    PalavraContada& operator=(const PalavraContada& outra) {
+        texto = outra.texto;
+        ContagemCopias::copias++;
+        return *this;
+    }
+    PalavraContada& operator=(PalavraContada&& outra) noexcept {
+        texto = std::move(outra.texto);
+        ContagemCopias::movidas++;
+        return *this;
+    }
+};
+
+inline std::string_view visaoChave(const PalavraContada& p) {
+    return std::string_view(p.texto.data(), p.texto.size());
+}
+inline int comparar(const PalavraContada& a, const PalavraContada& b) {
+    return visaoChave(a).compare(visaoChave(b));
+}
+inline int comparar(std::string_view a, const PalavraContada& b) {
+    return a.compare(visaoChave(b));
+}
+
+// le o texto pra uma List<PalavraContada> (emplaceBack), esvazia com popFront pra uma
+// tabela que cresce (a migracao tambem nao pode copiar) e remove metade das palavras
+// (remocao com dois filhos move o sucessor). Falha se tiver qualquer copia ou se o
+// texto de alguma palavra for pro heap mais de uma vez.
+bool rodarConferirCopias(const string& caminho) {
+    ifstream arquivo(caminho);
+    if (!arquivo) {
+        cout << "nao consegui abrir " << caminho << endl;
         return false;
     }
+    ContagemCopias::zerar();
+    const size_t SSO = TextoContado().capacity(); // ate aqui a palavra nao aloca
+    vector<string> distintas;
+    size_t lidas = 0, longas = 0;
+    bool ok = true;
+    {
+        List<PalavraContada> lista;
+        string palavra;
+        while (arquivo >> palavra && palavra != "###") {
+            string limpa = limpador(palavra);
+            longas += limpa.size() > SSO;
+            distintas.push_back(limpa);
+            lista.emplaceBack(limpa);
+            lidas++;
+        }
+        sort(distintas.begin(), distintas.end());
+        distintas.erase(unique(distintas.begin(), distintas.end()), distintas.end());
+
+        HashTable<PalavraContada> tabela(7, 2.0);
+        while (!lista.empty()) {
+            tabela.insert(lista.popFront());
+        }
+        size_t movidasInsercao = ContagemCopias::movidas;
+        size_t alocacoesInsercao = ContagemCopias::alocacoes;
+
+        cout << "palavras lidas: " << lidas << " (" << longas << " com mais de " << SSO
+             << " letras), distintas: " << distintas.size() << endl;
+        cout << "ate o no: " << ContagemCopias::copias << " copias, " << movidasInsercao
+             << " movidas, " << alocacoesInsercao << " alocacoes de texto" << endl;
+        // cada palavra: uma movida saindo da lista, e as novas mais uma entrando no no
+        if (ContagemCopias::copias != 0 || alocacoesInsercao != longas
+            || movidasInsercao != lidas + distintas.size()) {
+            ok = false;
+        }
+        if (static_cast<size_t>(tabela.length()) != distintas.size()) {
+            cout << "tabela ficou com " << tabela.length() << " palavras" << endl;
+            ok = false;
+        }
+        for (const string& p : distintas) {
+            if (!tabela.search(string_view(p))) {
+                cout << "sumiu: " << p << endl;
+                ok = false;
+                break;
+            }
+        }
+
+        // a chave da remocao e montada aqui (conta alocacao, mas nao copia)
+        for (size_t i = 0; i < distintas.size(); i += 2) {
+            tabela.remove(PalavraContada(distintas[i]));
+        }
+        cout << "depois de remover metade: " << ContagemCopias::copias << " copias, "
+             << ContagemCopias::movidas - movidasInsercao << " movidas" << endl;
+        if (ContagemCopias::copias != 0) {
+            ok = false;
+        }
+        for (size_t i = 0; i < distintas.size() && ok; i++) {
+            if (tabela.search(string_view(distintas[i])) != (i % 2 == 1)) {
+                cout << "remocao errada: " << distintas[i] << endl;
+                ok = false;
+            }
+        }
+    }
+    cout << (ok ? "OK" : "FALHOU") << endl;
+    return ok;
+}
+
+// CONSTRUCAO PARALELA x SERIAL: mede as duas e confere se as arvores sao identicas
+void rodarParalelo(const string& caminho, unsigned numThreads) {
+    ArquivoMapeado arquivo(caminho);
+    if (arquivo.data() == nullptr) {
+        cout << "nao consegui abrir " << caminho << endl;
+        return;
+    }
+
+    auto inicio = chrono::steady_clock::now();
+    HashTable<string> serial;
+    tokenizarTexto(arquivo.conteudo(), [&](std::string_view palavra) { serial.insert(palavra); });
+    chrono::duration<double> tempoSerial = chrono::steady_clock::now() - inicio;
 
-    return item == temp->getItem(); // o no encontrado
+    inicio = chrono::steady_clock::now();
+    HashTable<string> paralela;
+    paralela.construirParalelo(arquivo.conteudo(), numThreads);
+    chrono::duration<double> tempoParalelo = chrono::steady_clock::now() - inicio;
+
+    testarAlturas(paralela);
+    cout << endl;
+    cout << "serial:   " << tempoSerial.count() * 1000 << " ms" << endl;
+    cout << "paralelo: " << tempoParalelo.count() * 1000 << " ms com " << numThreads << " threads ("
+         << tempoSerial.count() / tempoParalelo.count() << "x)" << endl;
+    cout << "identica a serial: " << (paralela.mesmaEstrutura(serial) ? "sim" : "NAO") << endl;
 }
 
-// FUNCOES AUXILIARES AQUI
-string limpador(const string& palavra) {
-    string cleaned = "";
-    for (char c: palavra) {
-        if (!ispunct(c)) cleaned += c;
+// TABELA CONCORRENTE: teste de estresse + escalabilidade
+// uma trava global em volta da HashTable normal (o que a gente fazia antes), pra comparar
+class TabelaTravaGlobal {
+private:
+    HashTable<string> tabela;
+    std::mutex trava;
+
+public:
+    void insert(std::string_view chave) {
+        std::lock_guard<std::mutex> t(trava);
+        tabela.insert(chave);
+    }
+    bool search(std::string_view chave) {
+        std::lock_guard<std::mutex> t(trava);
+        return tabela.search(chave);
+    }
+    size_t bytesReservados() const { return tabela.bytesReservados(); }
+};
+
+// cada thread faz 'operacoes' sorteadas (semente fixa por thread) com 'leitura' % de buscas.
+// O total de achados sai da funcao: se ninguem usar o resultado o compilador pode sumir
+// com a busca inteira quando ela e inline (foi o que aconteceu com a trava global)
+template <typename Tabela>
+double medirMistura(Tabela& tabela, const vector<string>& palavras, unsigned numThreads, int leitura, size_t operacoes,
+                    size_t& totalAchados) {
+    std::atomic<size_t> somaAchados{0};
+    auto tarefa = [&](unsigned t) {
+        mt19937 gerador(1234 + t);
+        size_t achados = 0;
+        for (size_t i = 0; i < operacoes; i++) {
+            const string& palavra = palavras[gerador() % palavras.size()];
+            if (static_cast<int>(gerador() % 100) < leitura) {
+                achados += tabela.search(palavra);
+            } else {
+                tabela.insert(palavra);
+            }
+        }
+        somaAchados.fetch_add(achados, std::memory_order_relaxed);
+    };
+    auto inicio = chrono::steady_clock::now();
+    vector<std::thread> threads;
+    for (unsigned t = 0; t < numThreads; t++) {
+        threads.emplace_back(tarefa, t);
+    }
+    for (auto& th : threads) th.join();
+    chrono::duration<double> tempo = chrono::steady_clock::now() - inicio;
+    totalAchados = somaAchados.load();
+    return numThreads * operacoes / tempo.count() / 1e6;
+}
+
+// Estresse: cada thread insere as palavras de um pedaco so dela, remove metade e
+// fica buscando as dos outros no meio. No fim tem que sobrar exatamente a outra
+// metade de cada pedaco e todas as arvores tem que continuar AVL validas.
+bool estresseConcorrente(const vector<string>& distintas, unsigned numThreads) {
+    HashTableConcorrente<string> tabela(151, 0);
+    auto tarefa = [&](unsigned t) {
+        mt19937 gerador(99 + t);
+        for (int rodada = 0; rodada < 3; rodada++) {
+            for (size_t i = t; i < distintas.size(); i += numThreads) {
+                tabela.insert(distintas[i]);
+                tabela.search(distintas[gerador() % distintas.size()]);
+            }
+            for (size_t i = t; i < distintas.size(); i += numThreads) {
+                if ((i / numThreads) % 2 == 0 || rodada < 2) tabela.remove(distintas[i]);
+                tabela.buscarAltura(distintas[gerador() % distintas.size()]);
+            }
+        }
+    };
+    vector<std::thread> threads;
+    for (unsigned t = 0; t < numThreads; t++) {
+        threads.emplace_back(tarefa, t);
+    }
+    for (auto& th : threads) th.join();
+
+    size_t esperado = 0;
+    bool ok = true;
+    for (size_t i = 0; i < distintas.size(); i++) {
+        bool deveTer = (i / numThreads) % 2 != 0;
+        esperado += deveTer;
+        ok = ok && tabela.search(distintas[i]) == deveTer;
+    }
+    return ok && static_cast<size_t>(tabela.length()) == esperado && tabela.conferirArvores();
+}
+
+void rodarBenchConcorrente(const string& caminho) {
+    ArquivoMapeado arquivo(caminho);
+    if (arquivo.data() == nullptr) {
+        cout << "nao consegui abrir " << caminho << endl;
+        return;
+    }
+    vector<string> palavras;
+    tokenizarTexto(arquivo.conteudo(), [&](std::string_view palavra) { palavras.emplace_back(palavra); });
+    vector<string> distintas = palavras;
+    sort(distintas.begin(), distintas.end());
+    distintas.erase(unique(distintas.begin(), distintas.end()), distintas.end());
+
+    for (unsigned t : {1u, 4u, 16u}) {
+        cout << "estresse com " << t << " threads: " << (estresseConcorrente(distintas, t) ? "ok" : "FALHOU") << endl;
+    }
+
+    // memoria dos nos com metade das palavras dentro (o que a mistura abaixo usa)
+    auto metade = [&](auto& tabela) {
+        for (size_t i = 0; i < palavras.size(); i += 2) tabela.insert(palavras[i]);
+        return tabela.bytesReservados() / 1024;
+    };
+    {
+        HashTableConcorrente<string> padrao;
+        HashTableConcorrente<string> porGaveta(151, 151);
+        HashTableConcorrente<string> grande(1 << 20);
+        TabelaTravaGlobal global;
+        cout << "memoria dos nos: " << padrao.faixasUsadas() << " faixas " << metade(padrao) << " KiB | uma faixa por gaveta "
+             << metade(porGaveta) << " KiB | " << grande.faixasUsadas() << " faixas com 2^20 gavetas " << metade(grande)
+             << " KiB | trava global " << metade(global) << " KiB" << endl;
+    }
+
+    const size_t operacoes = 200000;
+    cout << "Mops/s (faixas | trava global)" << endl;
+    for (int leitura : {100, 95, 50}) {
+        cout << "leitura " << leitura << "%:";
+        for (unsigned t : {1u, 2u, 4u, 8u, 16u, 32u, 64u}) {
+            HashTableConcorrente<string> faixas;
+            TabelaTravaGlobal global;
+            // comeca com metade das palavras dentro
+            for (size_t i = 0; i < palavras.size(); i += 2) {
+                faixas.insert(palavras[i]);
+                global.insert(palavras[i]);
+            }
+            size_t achadosA, achadosB;
+            double a = medirMistura(faixas, palavras, t, leitura, operacoes / t, achadosA);
+            double b = medirMistura(global, palavras, t, leitura, operacoes / t, achadosB);
+            cout << "  " << t << "t: " << a << " | " << b;
+            // com uma thread a sequencia e a mesma: as duas tem que achar o mesmo tanto
+            if (t == 1 && achadosA != achadosB) cout << " (ACHADOS DIFERENTES)";
+        }
+        cout << endl;
+    }
+}
+
+// LEITURA SEM TRAVA x FAIXAS COM shared_mutex: latencia das buscas (p50/p99/p99.9)
+// com escritores inserindo e removendo sem parar nas mesmas gavetas
+template <typename Tabela>
+void medirLatenciaLeitura(const char* nome, const vector<string>& palavras, unsigned leitores, unsigned escritores) {
+    Tabela tabela;
+    for (size_t i = 0; i < palavras.size(); i += 2) {
+        tabela.insert(palavras[i]);
+    }
+    std::atomic<bool> parar{false};
+    vector<vector<uint32_t>> latencias(leitores);
+    auto ler = [&](unsigned t) {
+        mt19937 gerador(7 + t);
+        latencias[t].reserve(200000);
+        for (int i = 0; i < 200000; i++) {
+            const string& palavra = palavras[gerador() % palavras.size()];
+            auto antes = chrono::steady_clock::now();
+            tabela.search(palavra);
+            auto depois = chrono::steady_clock::now();
+            latencias[t].push_back(static_cast<uint32_t>(chrono::duration_cast<chrono::nanoseconds>(depois - antes).count()));
+        }
+    };
+    auto escrever = [&](unsigned t) {
+        mt19937 gerador(77 + t);
+        while (!parar.load(std::memory_order_relaxed)) {
+            const string& palavra = palavras[gerador() % palavras.size()];
+            if (gerador() % 2) tabela.insert(palavra);
+            else tabela.remove(palavra);
+        }
+    };
+    vector<std::thread> threads;
+    for (unsigned t = 0; t < escritores; t++) threads.emplace_back(escrever, t);
+    vector<std::thread> threadsLeitura;
+    for (unsigned t = 0; t < leitores; t++) threadsLeitura.emplace_back(ler, t);
+    for (auto& th : threadsLeitura) th.join();
+    parar = true;
+    for (auto& th : threads) th.join();
+
+    vector<uint32_t> todas;
+    for (auto& l : latencias) todas.insert(todas.end(), l.begin(), l.end());
+    sort(todas.begin(), todas.end());
+    auto percentil = [&](double p) { return todas[static_cast<size_t>(p * (todas.size() - 1))]; };
+    cout << nome << " " << leitores << " leitores, " << escritores << " escritores: p50 " << percentil(0.5)
+         << " ns | p99 " << percentil(0.99) << " ns | p99.9 " << percentil(0.999) << " ns"
+         << (tabela.conferirArvores() ? "" : " (ARVORE INVALIDA)") << endl;
+}
+
+void rodarBenchRCU(const string& caminho) {
+    ArquivoMapeado arquivo(caminho);
+    if (arquivo.data() == nullptr) {
+        cout << "nao consegui abrir " << caminho << endl;
+        return;
     }
+    // a distribuicao do texto ja e bem torta ("the", "and"...): as gavetas quentes apanham
+    vector<string> palavras;
+    tokenizarTexto(arquivo.conteudo(), [&](std::string_view palavra) { palavras.emplace_back(palavra); });
 
-    if (!cleaned.empty()) {
-        return cleaned;
+    for (unsigned escritores : {0u, 1u, 2u, 4u}) {
+        medirLatenciaLeitura<HashTableRCU<string>>("rcu   ", palavras, 2, escritores);
+        medirLatenciaLeitura<HashTableConcorrente<string>>("faixas", palavras, 2, escritores);
     }
 }
 
+// INGESTAO POR MMAP: o arquivo e mapeado e quebrado no lugar, cada palavra vai como
+// string_view direto pra tabela (sem List e sem copia; string so e criada se for nova)
+void rodarIngestaoMmap(const string& caminho) {
+    HashTable<string> tabela;
+    ArquivoMapeado arquivo(caminho);
+    if (arquivo.data() == nullptr) {
+        cout << "nao consegui abrir " << caminho << endl;
+        return;
+    }
+
+    auto inicio = chrono::steady_clock::now();
+    size_t palavras = 0;
+    size_t consumidos = tokenizarTexto(arquivo.conteudo(), [&](std::string_view palavra) {
+        tabela.insert(palavra);
+        palavras++;
+    });
+    chrono::duration<double> tempo = chrono::steady_clock::now() - inicio;
+
+    testarAlturas(tabela);
+
+    double mb = consumidos / (1024.0 * 1024.0);
+    cout << endl;
+    cout << "ingestao mmap: " << palavras << " palavras, " << mb << " MB em "
+         << tempo.count() * 1000 << " ms (" << mb / tempo.count() << " MB/s)" << endl;
+}
 
+int main(int argc, char* argv[]) {
+    // modos extras: sem argumento roda o testador de sempre
+    // ./main --bench-hash < texto_base.txt
+    if (argc > 1 && string(argv[1]) == "--bench-hash") {
+        rodarBenchHash(cin);
+        return 0;
+    }
+    // ./main --mmap texto_base.txt
+    if (argc > 2 && string(argv[1]) == "--mmap") {
+        rodarIngestaoMmap(argv[2]);
+        return 0;
+    }
+    // ./main --bulk texto_base.txt
+    if (argc > 2 && string(argv[1]) == "--bulk") {
+        rodarBulk(argv[2]);
+        return 0;
+    }
+    // ./main --bench-baldes texto_base.txt
+    if (argc > 2 && string(argv[1]) == "--bench-baldes") {
+        rodarBenchBaldes(argv[2]);
+        return 0;
+    }
+    // ./main --internado texto_base.txt
+    if (argc > 2 && string(argv[1]) == "--internado") {
+        rodarInternado(argv[2]);
+        return 0;
+    }
+    // ./main --bench-arvore texto_base.txt
+    if (argc > 2 && string(argv[1]) == "--bench-arvore") {
+        rodarBenchArvore(argv[2]);
+        return 0;
+    }
+    // ./main --bench-lote texto_base.txt
+    if (argc > 2 && string(argv[1]) == "--bench-lote") {
+        rodarBenchLote(argv[2]);
+        return 0;
+    }
+    // ./main --frequencias texto_base.txt [k]
+    if (argc > 2 && string(argv[1]) == "--frequencias") {
+        rodarFrequencias(argv[2], argc > 3 ? strtoul(argv[3], nullptr, 10) : 10);
+        return 0;
+    }
+    // ./main --faixa texto_base.txt Ba Bi   (ou so o prefixo: ./main --faixa texto_base.txt Ba)
+    if (argc > 3 && string(argv[1]) == "--faixa") {
+        string ate = argc > 4 ? argv[4] : "";
+        rodarFaixa(argv[2], argv[3], argc > 4 ? &ate : nullptr);
+        return 0;
+    }
+    // ./main --exportar texto_base.txt [saida.txt]
+    if (argc > 2 && string(argv[1]) == "--exportar") {
+        rodarExportar(argv[2], argc > 3 ? argv[3] : nullptr);
+        return 0;
+    }
+    // ./main --snapshot-salvar texto_base.txt tabela.snap
+    if (argc > 3 && string(argv[1]) == "--snapshot-salvar") {
+        rodarSalvarSnapshot(argv[2], argv[3]);
+        return 0;
+    }
+    // ./main --snapshot tabela.snap (testador direto no arquivo, sem ler o texto)
+    if (argc > 2 && string(argv[1]) == "--snapshot") {
+        rodarConsultarSnapshot(argv[2]);
+        return 0;
+    }
+    // ./main --conferir-snapshot texto_base.txt
+    if (argc > 2 && string(argv[1]) == "--conferir-snapshot") {
+        return rodarConferirSnapshot(argv[2]) ? 0 : 1;
+    }
+    // ./main --ingestao texto_base.txt [bloco] [checkpoint]
+    if (argc > 2 && string(argv[1]) == "--ingestao") {
+        size_t bloco = argc > 3 ? strtoul(argv[3], nullptr, 10) : 64 * 1024;
+        rodarIngestao(argv[2], bloco > 0 ? bloco : 64 * 1024, argc > 4 ? argv[4] : nullptr);
+        return 0;
+    }
+    // ./main --conferir-ingestao texto_base.txt (sai com 1 se alguma tabela saiu diferente)
+    if (argc > 2 && string(argv[1]) == "--conferir-ingestao") {
+        return rodarConferirIngestao(argv[2]) ? 0 : 1;
+    }
+    // ./main --bench-diario texto_base.txt [palavras]
+    if (argc > 2 && string(argv[1]) == "--bench-diario") {
+        rodarBenchDiario(argv[2], argc > 3 ? strtoul(argv[3], nullptr, 10) : 100000);
+        return 0;
+    }
+    // ./main --conferir-diario texto_base.txt (sai com 1 se a recuperacao deu diferente)
+    if (argc > 2 && string(argv[1]) == "--conferir-diario") {
+        return rodarConferirDiario(argv[2]) ? 0 : 1;
+    }
+    // ./main --suite texto_base.txt [saida.json] [chaves geradas por distribuicao]
+    if (argc > 2 && string(argv[1]) == "--suite") {
+        rodarSuite(argv[2], argc > 3 ? argv[3] : "suite.json", argc > 4 ? strtoul(argv[4], nullptr, 10) : 200000);
+        return 0;
+    }
+    // ./main --estatisticas texto_base.txt [json|prometheus] (compilado com -DCOM_ESTATISTICAS)
+    if (argc > 2 && string(argv[1]) == "--estatisticas") {
+        return rodarEstatisticas(argv[2], argc > 3 ? argv[3] : "json") ? 0 : 1;
+    }
+    // ./main --conferir-copias texto_base.txt (sai com 1 se alguma palavra foi copiada)
+    if (argc > 2 && string(argv[1]) == "--conferir-copias") {
+        return rodarConferirCopias(argv[2]) ? 0 : 1;
+    }
+    // ./main --bench-lista texto_base.txt
+    if (argc > 2 && string(argv[1]) == "--bench-lista") {
+        rodarBenchLista(argv[2]);
+        return 0;
+    }
+    // ./main --paralelo texto_base.txt [threads]
+    if (argc > 2 && string(argv[1]) == "--paralelo") {
+        unsigned threads = argc > 3 ? static_cast<unsigned>(atoi(argv[3])) : std::thread::hardware_concurrency();
+        rodarParalelo(argv[2], threads);
+        return 0;
+    }
+    // ./main --bench-concorrente texto_base.txt
+    if (argc > 2 && string(argv[1]) == "--bench-concorrente") {
+        rodarBenchConcorrente(argv[2]);
+        return 0;
+    }
+    // ./main --bench-rcu texto_base.txt
+    if (argc > 2 && string(argv[1]) == "--bench-rcu") {
+        rodarBenchRCU(argv[2]);
+        return 0;
+    }
+    // ./main --tokens texto_base.txt
+    if (argc > 2 && string(argv[1]) == "--tokens") {
+        rodarConferirTokens(argv[2]);
+        return 0;
+    }
 
-int main() {
     /*
      *  Atualização aqui: Coloquei List e as funcoes originais que o professor colocou no
      *  Classroom
@@ -760,61 +6978,15 @@ int main() {
     string palavra, limpar;
 
     while (cin >> palavra && palavra != "###") {
-        limpar.clear();
         limpar = limpador(palavra);
-        lista_arvore.insertBack(limpar);
-        limpar.clear();
+        lista_arvore.insertBack(std::move(limpar)); // a palavra limpa vai movida ate o no
     }
 
     while (!lista_arvore.empty()) {
-        tabela.insert(lista_arvore.getItemFront());
-        lista_arvore.removeFront();
-    }
-
-    // ---- TESTADOR DE PROGRAMA AQUI ----
-    // TERMINOU? NAO ESQUECER DE TIRAR O INCLUDE <vector>
-    // USANDO VECTOR APENAS PARA TESTAR AS PALAVRAS CHAVES
-    // USANDO PRA ARMAZENAR AS ALTURAS
-    // -1 REPRESENTA NAO ENCONTRADO
-    // como usar o testador -> COLE O TEXTO BASE E Dê ENTER DUAS VEZES
-    vector<std::string> nomes = {
-        "Frodo", "Bilbo", "Legolas", "Pippin", "Merry",
-        "Galadriel", "Butterbur", "Sam", "Faramir", "Peregrin",
-        "Gandalf", "Gollum", "Bombadil", "Elrond", "Sauron",
-        "Aragorn", "Saruman", "Gildor", "Elanor", "Morgoth"
-    };
-    vector<int> valores = {
-        6, 6, -1, 7, 7, -1, 6, 6, -1,
-        6, 7, 7, 6, 7, 6, 6, 6, 6, -1, -1
-    };
-
-    int erro_n = 0;
-    int acerto_n = 0;
-
-    for (int i = 0; i < valores.size(); i++) {
-        string palavraChave = limpador(nomes[i]);
-        /*
-        if (!palavraChave.empty()) {
-            if (tabela.buscarMostrarAltura(palavraChave) != -1) {
-                cout << palavraChave << tabela.buscarMostrarAltura(palavraChave) << endl;
-            } else {
-                cout << "Nao encontrado" << endl;
-            }
-           }
-        */
-
-        if (tabela.buscarMostrarAltura(palavraChave) == valores[i]) {
-            cout << palavraChave << ": " << tabela.buscarMostrarAltura(palavraChave) << " - "<< "CORRETO" << endl;
-            acerto_n++;
-        } else {
-            cout << palavraChave << ": " << tabela.buscarMostrarAltura(palavraChave) << " - " << "ERRADO" << endl;
-            erro_n++;
-        }
+        tabela.insert(lista_arvore.popFront());
     }
 
-    cout << endl;
-    cout << "acertos: " << acerto_n << endl;
-    cout << "erros: " << erro_n << endl;
+    testarAlturas(tabela);
 
     return 0;
 
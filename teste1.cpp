@@ -236,17 +236,13 @@ private:
         return y;
     }
 
-    AVLNode<T>* insert(AVLNode<T>* node, T key) {
-        if (node == nullptr)
-            return new AVLNode<T>(key);
-
-        if (key < node->key)
-            node->left = insert(node->left, key);
-        else if (key > node->key)
-            node->right = insert(node->right, key);
-        else
-            return node;
+    // Sem recursao: a descida guarda o caminho (o endereco de cada ponteiro de filho)
+    // num vetor fixo e depois sobe por ele rebalanceando. Uma AVL de altura 64 teria
+    // mais de 10^13 nos, entao o vetor nunca enche.
+    static const int ALTURA_MAX = 64;
 
+    // o que o insert fazia na volta da recursao
+    AVLNode<T>* balancearInsert(AVLNode<T>* node, const T& key) {
         node->height = 1 + max(height(node->left), height(node->right));
         int balance = balanceFactor(node);
 
@@ -269,6 +265,30 @@ private:
         return node;
     }
 
+    AVLNode<T>* insert(AVLNode<T>* node, T key) {
+        AVLNode<T>** caminho[ALTURA_MAX];
+        int n = 0;
+        AVLNode<T>** link = &node;
+        while (*link != nullptr) {
+            if (key < (*link)->key) {
+                caminho[n++] = link;
+                link = &(*link)->left;
+            } else if (key > (*link)->key) {
+                caminho[n++] = link;
+                link = &(*link)->right;
+            } else {
+                return node; // ja existe: nada muda no caminho
+            }
+        }
+        *link = new AVLNode<T>(key);
+
+        while (n > 0) {
+            link = caminho[--n];
+            *link = balancearInsert(*link, key);
+        }
+        return node;
+    }
+
     AVLNode<T>* minValueNode(AVLNode<T>* node) {
         AVLNode<T>* current = node;
         while (current->left != nullptr)
@@ -276,31 +296,8 @@ private:
         return current;
     }
 
-    AVLNode<T>* deleteNode(AVLNode<T>* root, T key) {
-        if (root == nullptr) return root;
-
-        if (key < root->key)
-            root->left = deleteNode(root->left, key);
-        else if (key > root->key)
-            root->right = deleteNode(root->right, key);
-        else {
-            if ((root->left == nullptr) || (root->right == nullptr)) {
-                AVLNode<T>* temp = root->left ? root->left : root->right;
-                if (temp == nullptr) {
-                    temp = root;
-                    root = nullptr;
-                } else
-                    *root = *temp;
-                delete temp;
-            } else {
-                AVLNode<T>* temp = minValueNode(root->right);
-                root->key = temp->key;
-                root->right = deleteNode(root->right, temp->key);
-            }
-        }
-
-        if (root == nullptr) return root;
-
+    // o que o deleteNode fazia na volta da recursao
+    AVLNode<T>* balancearDelete(AVLNode<T>* root) {
         root->height = 1 + max(height(root->left), height(root->right));
         int balance = balanceFactor(root);
 
@@ -323,6 +320,47 @@ private:
         return root;
     }
 
+    AVLNode<T>* deleteNode(AVLNode<T>* root, T key) {
+        AVLNode<T>** caminho[ALTURA_MAX];
+        int n = 0;
+        AVLNode<T>** link = &root;
+        while (*link != nullptr) {
+            AVLNode<T>* atual = *link;
+            if (key < atual->key) {
+                caminho[n++] = link;
+                link = &atual->left;
+            } else if (key > atual->key) {
+                caminho[n++] = link;
+                link = &atual->right;
+            } else if (atual->left != nullptr && atual->right != nullptr) {
+                // dois filhos: puxa a chave do menor da direita e continua descendo pra apagar ela la
+                AVLNode<T>* temp = minValueNode(atual->right);
+                atual->key = temp->key;
+                key = temp->key;
+                caminho[n++] = link;
+                link = &atual->right;
+            } else {
+                AVLNode<T>* temp = atual->left ? atual->left : atual->right;
+                if (temp == nullptr) {
+                    *link = nullptr;
+                    delete atual;
+                } else {
+                    *atual = *temp;
+                    delete temp;
+                }
+                caminho[n++] = link;
+                break;
+            }
+        }
+
+        while (n > 0) {
+            link = caminho[--n];
+            if (*link != nullptr)
+                *link = balancearDelete(*link);
+        }
+        return root;
+    }
+
     void inorder(AVLNode<T>* root) {
         if (root != nullptr) {
             inorder(root->left);
@@ -333,11 +371,10 @@ private:
 
     // CORRIGIDO: Renomeado de search para findNode (o helper recursivo)
     AVLNode<T>* findNode(AVLNode<T>* node, T key) {
-        if (node == nullptr || node->key == key)
-            return node;
-        if (key < node->key)
-            return findNode(node->left, key);
-        return findNode(node->right, key);
+        while (node != nullptr && !(node->key == key)) {
+            node = key < node->key ? node->left : node->right;
+        }
+        return node;
     }
 
     // CORRIGIDO: Helper recursivo para gerar o código DOT
@@ -396,7 +433,10 @@ private:
         size_t hashValue = 0;
         size_t n = key.length();
         for (size_t i = 0; i < n; ++i) {
-            hashValue += key[i] * static_cast<size_t>(std::pow(128, n - i - 1));
+            // 128^k e potencia de 2: shift no lugar do pow (k >= 10 dava 0 no cast do double)
+            size_t k = n - i - 1;
+            size_t potencia = k < 10 ? static_cast<size_t>(1) << (7 * k) : 0;
+            hashValue += key[i] * potencia;
             hashValue %= SIZE;
         }
         return hashValue;